@@ -0,0 +1,191 @@
+/*
+use at own risk
+*/
+
+// microbenchmarks for the hot paths of the board and the threat map, every benchmark runs over a fixed corpus of
+// opening, middlegame and endgame positions and is repeated for a number of samples to get the variance
+//
+// bench [samples]                  default is 10 samples
+//
+// build it with the other sources, optimizations on and asserts off, e.g.
+// g++ -std=c++17 -O2 -DNDEBUG -pthread lchessBitboard.cpp lchessBoard.cpp lchessThreatMap.cpp lchessZobrist.cpp lchessEvaluation.cpp lchessNetwork.cpp lchessInstrumentation.cpp lchessDiagnostics.cpp bench.cpp -o bench
+
+#include "lchessBoard.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+
+
+
+static const char* corpus[][2] =
+{
+	{ "opening" , "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" },
+	{ "opening" , "rnbqkbnr/pp1ppppp/8/2p5/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2" },
+	{ "opening" , "rnbqkb1r/pppp1ppp/5n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3" },
+	{ "opening" , "rnbqkb1r/ppp2ppp/4pn2/3p4/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 2 4" },
+	{ "middlegame" , "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" },
+	{ "middlegame" , "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10" },
+	{ "middlegame" , "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8" },
+	{ "middlegame" , "2rq1rk1/pp1bppbp/2np1np1/8/3NP3/1BN1BP2/PPPQ2PP/2KR3R b - - 0 11" },
+	{ "endgame" , "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" },
+	{ "endgame" , "8/5pk1/6p1/8/8/6P1/5PK1/8 w - - 0 1" },
+	{ "endgame" , "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1" },
+	{ "endgame" , "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1" },
+};
+
+static const int corpusSize = sizeof( corpus )/sizeof( corpus[0] );
+
+
+
+// results are added here so the compiler cannot drop the benchmarked calls
+static volatile uint64_t sink = 0;
+
+
+
+// runs op, which works through the whole corpus and returns the number of operations it did, until a sample takes
+// about 50ms and prints the mean time per operation with its variance over all samples
+template< typename Operation >
+static void runBenchmark( const char* name , const int samples , Operation op )
+{
+	// find how many rounds fill a sample
+	int rounds = 1;
+	while ( true )
+	{
+		Timer timer;
+		timer.start();
+		for ( int r = 0 ; r < rounds ; ++r ) op();
+		if ( timer.getTime() > 0.05 || rounds >= ( 1 << 24 ) ) break;
+		rounds *= 2;
+	}
+
+	std::vector<double> nanoseconds;
+	for ( int s = 0 ; s < samples ; ++s )
+	{
+		uint64_t operations = 0;
+		Timer timer;
+		timer.start();
+		for ( int r = 0 ; r < rounds ; ++r ) operations += op();
+		nanoseconds.push_back( timer.getTime()*1e9/double( operations ) );
+	}
+
+	double mean = 0;
+	for ( const double ns : nanoseconds ) mean += ns;
+	mean /= samples;
+	double variance = 0;
+	for ( const double ns : nanoseconds ) variance += ( ns-mean )*( ns-mean );
+	variance /= std::max( 1 , samples-1 );
+
+	std::cout << std::left << std::setw( 34 ) << name << std::right << std::fixed
+		<< std::setw( 12 ) << std::setprecision( 2 ) << mean
+		<< std::setw( 16 ) << std::setprecision( 0 ) << 1e9/mean
+		<< std::setw( 14 ) << std::setprecision( 4 ) << variance
+		<< std::setw( 10 ) << std::setprecision( 2 ) << 100*std::sqrt( variance )/mean << "%" << std::endl;
+}
+
+
+
+int main( int argc , char** argv )
+{
+	lchessBoard::allocateMemory();
+
+	const int samples = ( argc > 1 ) ? std::max( 2 , atoi( argv[1] ) ) : 10;
+
+	std::vector<lchessBoard> boards( corpusSize );
+	int categoryCounts[3] = {};
+	for ( int i = 0 ; i < corpusSize ; ++i )
+	{
+		boards[i].init();
+		if ( !boards[i].loadFen( corpus[i][1] ) ) return 1;
+		categoryCounts[ corpus[i][0][0] == 'o' ? 0 : ( corpus[i][0][0] == 'm' ? 1 : 2 ) ]++;
+	}
+
+	// the legal moves of every position, played by the move benchmark
+	std::vector<lchessMoveList> legalMoves( corpusSize );
+	for ( int i = 0 ; i < corpusSize ; ++i ) boards[i].generateMoves( legalMoves[i] );
+
+	std::cout << "corpus: " << categoryCounts[0] << " opening, " << categoryCounts[1] << " middlegame, " << categoryCounts[2] << " endgame positions, " << samples << " samples" << std::endl << std::endl;
+	std::cout << std::left << std::setw( 34 ) << "benchmark" << std::right << std::setw( 12 ) << "ns/op" << std::setw( 16 ) << "ops/s" << std::setw( 14 ) << "variance" << std::setw( 11 ) << "stddev" << std::endl;
+
+	runBenchmark( "getLegalMoves (white)" , samples , [&]() -> uint64_t
+	{
+		lchessMoveList moves;
+		for ( lchessBoard& board : boards )
+		{
+			board.getLegalMoves( moves , WHITE );
+			sink = sink + moves.size();
+		}
+		return boards.size();
+	} );
+
+	runBenchmark( "getLegalMoves (black)" , samples , [&]() -> uint64_t
+	{
+		lchessMoveList moves;
+		for ( lchessBoard& board : boards )
+		{
+			board.getLegalMoves( moves , BLACK );
+			sink = sink + moves.size();
+		}
+		return boards.size();
+	} );
+
+	runBenchmark( "generateMoves (side to move)" , samples , [&]() -> uint64_t
+	{
+		lchessMoveList moves;
+		for ( const lchessBoard& board : boards )
+		{
+			board.generateMoves( moves );
+			sink = sink + moves.size();
+		}
+		return boards.size();
+	} );
+
+	// move cannot be measured alone without changing the corpus, so every move is taken back right away
+	runBenchmark( "move (makeMove + unmakeMove)" , samples , [&]() -> uint64_t
+	{
+		uint64_t operations = 0;
+		for ( int i = 0 ; i < corpusSize ; ++i )
+		{
+			for ( const lchessCompactMove move : legalMoves[i] )
+			{
+				if ( boards[i].makeMove( move ) ) boards[i].unmakeMove();
+			}
+			operations += legalMoves[i].size();
+		}
+		return operations;
+	} );
+
+	runBenchmark( "lchessThreatMap::fromBoard" , samples , [&]() -> uint64_t
+	{
+		for ( const lchessBoard& board : boards )
+		{
+			const lchessThreatMap threatMap = lchessThreatMap::fromBoard( board );
+			sink = sink + threatMap.isWhiteThreat( 36 );
+		}
+		return boards.size();
+	} );
+
+	runBenchmark( "isWhiteInCheck" , samples , [&]() -> uint64_t
+	{
+		for ( const lchessBoard& board : boards ) sink = sink + board.isWhiteInCheck();
+		return boards.size();
+	} );
+
+	runBenchmark( "isBlackInCheck" , samples , [&]() -> uint64_t
+	{
+		for ( const lchessBoard& board : boards ) sink = sink + board.isBlackInCheck();
+		return boards.size();
+	} );
+
+	runBenchmark( "evaluatePosition" , samples , [&]() -> uint64_t
+	{
+		for ( const lchessBoard& board : boards ) sink = sink + board.evaluatePosition();
+		return boards.size();
+	} );
+
+#ifdef LCHESS_INSTRUMENTATION
+	std::cout << std::endl;
+	lchessInstrumentation::dump( std::cout );
+#endif
+	return 0;
+}
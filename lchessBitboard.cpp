@@ -0,0 +1,192 @@
+/*
+use at own risk
+*/
+#include "lchessBitboard.hpp"
+
+
+
+lchessBitboard::Magic lchessBitboard::rookMagics[64];
+lchessBitboard::Magic lchessBitboard::bishopMagics[64];
+
+uint64_t lchessBitboard::rookAttackTable[0x19000];
+uint64_t lchessBitboard::bishopAttackTable[0x1480];
+
+
+
+static constexpr int rookDirections[4][2] = { { 0 , 1 } , { 0 , -1 } , { -1 , 0 } , { 1 , 0 } };
+static constexpr int bishopDirections[4][2] = { { -1 , -1 } , { 1 , -1 } , { -1 , 1 } , { 1 , 1 } };
+
+
+
+// walks the rays square by square, only used to build the tables
+constexpr uint64_t lchessBitboard::slidingAttacks( const int index , const uint64_t occupancy , const int directions[4][2] )
+{
+	uint64_t attacks = 0;
+	for ( int d = 0 ; d < 4 ; ++d )
+	{
+		for ( int f = index%8+directions[d][0] , r = index/8+directions[d][1] ; f >= 0 && f < 8 && r >= 0 && r < 8 ; f += directions[d][0] , r += directions[d][1] )
+		{
+			attacks |= squareBit( r*8+f );
+			// stop at any piece
+			if ( occupancy & squareBit( r*8+f ) ) break;
+		}
+	}
+	return attacks;
+}
+
+
+
+constexpr lchessBitboard::AttackTables lchessBitboard::buildAttackTables()
+{
+	AttackTables t = {};
+
+	const int knightSteps[8][2] = { { -1 , 2 } , { 1 , 2 } , { -1 , -2 } , { 1 , -2 } , { -2 , -1 } , { -2 , 1 } , { 2 , -1 } , { 2 , 1 } };
+	const int kingSteps[8][2] = { { 0 , -1 } , { 0 , 1 } , { -1 , 0 } , { 1 , 0 } , { -1 , -1 } , { 1 , -1 } , { -1 , 1 } , { 1 , 1 } };
+
+	for ( int i = 0 ; i < 64 ; ++i )
+	{
+		int x = i%8;
+		int y = i/8;
+
+		for ( int s = 0 ; s < 8 ; ++s )
+		{
+			int f = x+knightSteps[s][0];
+			int r = y+knightSteps[s][1];
+			if ( f >= 0 && f < 8 && r >= 0 && r < 8 ) t.knight[i] |= squareBit( r*8+f );
+
+			f = x+kingSteps[s][0];
+			r = y+kingSteps[s][1];
+			if ( f >= 0 && f < 8 && r >= 0 && r < 8 ) t.king[i] |= squareBit( r*8+f );
+		}
+
+		// white pawns capture up, black pawns capture down
+		if ( y < 7 && x-1 >= 0 ) t.pawn[0][i] |= squareBit( (y+1)*8+(x-1) );
+		if ( y < 7 && x+1 < 8 ) t.pawn[0][i] |= squareBit( (y+1)*8+(x+1) );
+		if ( y > 0 && x-1 >= 0 ) t.pawn[1][i] |= squareBit( (y-1)*8+(x-1) );
+		if ( y > 0 && x+1 < 8 ) t.pawn[1][i] |= squareBit( (y-1)*8+(x+1) );
+
+		t.rookRays[i] = slidingAttacks( i , 0 , rookDirections );
+		t.bishopRays[i] = slidingAttacks( i , 0 , bishopDirections );
+	}
+
+	for ( int a = 0 ; a < 64 ; ++a )
+	{
+		for ( int b = 0 ; b < 64 ; ++b )
+		{
+			if ( a == b ) continue;
+			const int (*directions)[2] = nullptr;
+			if ( t.bishopRays[a] & squareBit( b ) ) directions = bishopDirections;
+			if ( t.rookRays[a] & squareBit( b ) ) directions = rookDirections;
+			if ( !directions ) continue;
+
+			t.between[a][b] = slidingAttacks( a , squareBit( b ) , directions ) & slidingAttacks( b , squareBit( a ) , directions );
+			t.line[a][b] = ( slidingAttacks( a , 0 , directions ) & slidingAttacks( b , 0 , directions ) ) | squareBit( a ) | squareBit( b );
+		}
+	}
+	return t;
+}
+
+
+
+constexpr lchessBitboard::AttackTables lchessBitboard::tables = lchessBitboard::buildAttackTables();
+
+
+
+void lchessBitboard::init()
+{
+	initMagics( rookMagics , rookAttackTable , rookDirections );
+	initMagics( bishopMagics , bishopAttackTable , bishopDirections );
+}
+
+
+
+void lchessBitboard::print( const uint64_t bitboard )
+{
+	std::cout << "+---+---+---+---+---+---+---+---+" << std::endl;
+	for ( int y = 7 ; y >= 0 ; --y )
+	{
+		for ( int x = 0 ; x < 8 ; ++x )
+		{
+			std::cout << "|";
+			if ( ( bitboard >> (y*8+x) ) & 1 ) std::cout << " X ";
+			else std::cout << "   ";
+		}
+		std::cout << "|" << std::endl << "+---+---+---+---+---+---+---+---+" << std::endl;
+	}
+}
+
+
+
+/*
+private functions
+*/
+
+
+
+// finds a magic number for every square by trial and error, the random generator is seeded with fixed values so the
+// tables are the same on every run and the search finishes in a few milliseconds
+void lchessBitboard::initMagics( Magic* magics , uint64_t* table , const int directions[4][2] )
+{
+	static const uint64_t seeds[8] = { 728 , 10316 , 55013 , 32803 , 12281 , 15100 , 16645 , 255 };
+
+	uint64_t occupancies[4096];
+	uint64_t references[4096];
+	int epoch[4096] = {};
+	int attempt = 0;
+
+	for ( int i = 0 ; i < 64 ; ++i )
+	{
+		Magic& m = magics[i];
+		int x = i%8;
+		int y = i/8;
+
+		// the board edges are not relevant for the occupancy unless the piece is on them
+		uint64_t edges = ( ( RANK_1 | RANK_8 ) & ~( RANK_1 << (y*8) ) ) | ( ( FILE_A | FILE_H ) & ~( FILE_A << x ) );
+		m.mask = slidingAttacks( i , 0 , directions ) & ~edges;
+		m.shift = 64-popCount( m.mask );
+		m.attacks = ( i == 0 ) ? table : magics[i-1].attacks+( uint64_t(1) << ( 64-magics[i-1].shift ) );
+
+		// enumerate all subsets of the mask (carry-rippler) and store the reference attacks
+		int size = 0;
+		uint64_t occupancy = 0;
+		do
+		{
+			occupancies[size] = occupancy;
+			references[size] = slidingAttacks( i , occupancy , directions );
+			++size;
+			occupancy = ( occupancy-m.mask ) & m.mask;
+		} while ( occupancy );
+
+		uint64_t seed = seeds[y];
+		auto random = [&seed]() -> uint64_t
+		{
+			// xorshift64star
+			seed ^= seed >> 12;
+			seed ^= seed << 25;
+			seed ^= seed >> 27;
+			return seed * 2685821657736338717ULL;
+		};
+
+		for ( int k = 0 ; k < size ; )
+		{
+			// magics with few set bits work best
+			for ( m.magic = 0 ; popCount( ( m.magic * m.mask ) >> 56 ) < 6 ; ) m.magic = random() & random() & random();
+
+			++attempt;
+			for ( k = 0 ; k < size ; ++k )
+			{
+				uint64_t index = ( ( occupancies[k] & m.mask ) * m.magic ) >> m.shift;
+				if ( epoch[index] < attempt )
+				{
+					epoch[index] = attempt;
+					m.attacks[index] = references[k];
+				}
+				else if ( m.attacks[index] != references[k] )
+				{
+					// destructive collision, try another magic
+					break;
+				}
+			}
+		}
+	}
+}
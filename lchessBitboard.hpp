@@ -0,0 +1,171 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+
+/*
+a bitboard is a 64 bit set of squares, bit i is the square with index i (a1 = 0, b1 = 1, ..., h8 = 63)
+*/
+class lchessBitboard
+{
+public:
+	static constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+	static constexpr uint64_t FILE_H = 0x8080808080808080ULL;
+	static constexpr uint64_t RANK_1 = 0x00000000000000FFULL;
+	static constexpr uint64_t RANK_3 = 0x0000000000FF0000ULL;
+	static constexpr uint64_t RANK_6 = 0x0000FF0000000000ULL;
+	static constexpr uint64_t RANK_8 = 0xFF00000000000000ULL;
+	// a1 is a dark square
+	static constexpr uint64_t DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+	static constexpr uint64_t LIGHT_SQUARES = ~DARK_SQUARES;
+
+	// finds the magics for the rook and bishop lookups, has to be called once before rookAttacks, bishopAttacks or
+	// queenAttacks are used, all other tables are built at compile time
+	static void init();
+
+	static constexpr inline uint64_t squareBit( const int index )
+	{
+		return uint64_t(1) << index;
+	}
+
+	static inline int popCount( const uint64_t bitboard )
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_popcountll( bitboard );
+#elif defined(_MSC_VER) && defined(_WIN64)
+		return int( __popcnt64( bitboard ) );
+#else
+		uint64_t b = bitboard - ( ( bitboard >> 1 ) & 0x5555555555555555ULL );
+		b = ( b & 0x3333333333333333ULL ) + ( ( b >> 2 ) & 0x3333333333333333ULL );
+		b = ( b + ( b >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+		return int( ( b * 0x0101010101010101ULL ) >> 56 );
+#endif
+	}
+
+	// index of the least significant set bit, the bitboard must not be empty
+	static inline int bitScanForward( const uint64_t bitboard )
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll( bitboard );
+#elif defined(_MSC_VER) && defined(_WIN64)
+		unsigned long index;
+		_BitScanForward64( &index , bitboard );
+		return int( index );
+#else
+		int index = 0;
+		while ( !( ( bitboard >> index ) & 1 ) ) ++index;
+		return index;
+#endif
+	}
+
+	// removes the least significant set bit and returns its index, the bitboard must not be empty
+	static inline int popLsb( uint64_t& bitboard )
+	{
+		const int index = bitScanForward( bitboard );
+		bitboard &= bitboard - 1;
+		return index;
+	}
+
+	static inline uint64_t knightAttacks( const int index )
+	{
+		return tables.knight[index];
+	}
+
+	static inline uint64_t kingAttacks( const int index )
+	{
+		return tables.king[index];
+	}
+
+	// the squares a pawn of the given color on index attacks
+	static inline uint64_t pawnAttacks( const BYTE color , const int index )
+	{
+		return tables.pawn[color == WHITE ? 0 : 1][index];
+	}
+
+	// rook and bishop attacks on an empty board
+	static inline uint64_t rookRays( const int index )
+	{
+		return tables.rookRays[index];
+	}
+
+	static inline uint64_t bishopRays( const int index )
+	{
+		return tables.bishopRays[index];
+	}
+
+	static inline uint64_t rookAttacks( const int index , const uint64_t occupancy )
+	{
+		const Magic& m = rookMagics[index];
+		return m.attacks[ ( ( occupancy & m.mask ) * m.magic ) >> m.shift ];
+	}
+
+	static inline uint64_t bishopAttacks( const int index , const uint64_t occupancy )
+	{
+		const Magic& m = bishopMagics[index];
+		return m.attacks[ ( ( occupancy & m.mask ) * m.magic ) >> m.shift ];
+	}
+
+	static inline uint64_t queenAttacks( const int index , const uint64_t occupancy )
+	{
+		return rookAttacks( index , occupancy ) | bishopAttacks( index , occupancy );
+	}
+
+	// the squares strictly between two squares on a common rank, file or diagonal, empty otherwise
+	static inline uint64_t between( const int from , const int to )
+	{
+		return tables.between[from][to];
+	}
+
+	// the full rank, file or diagonal through two squares, empty if they do not share one
+	static inline uint64_t line( const int from , const int to )
+	{
+		return tables.line[from][to];
+	}
+
+	static void print( const uint64_t bitboard );
+
+private:
+	// a "fancy" magic entry, the relevant occupancy bits are hashed into a per square slice of the attack table
+	struct Magic
+	{
+		uint64_t mask;
+		uint64_t magic;
+		uint64_t* attacks;
+		int shift;
+	};
+
+	static Magic rookMagics[64];
+	static Magic bishopMagics[64];
+
+	// all rook and bishop attack sets, indexed through the magics
+	static uint64_t rookAttackTable[0x19000];
+	static uint64_t bishopAttackTable[0x1480];
+
+	// every table that does not depend on the occupancy, computed by the compiler and stored in the binary
+	struct AttackTables
+	{
+		uint64_t knight[64];
+		uint64_t king[64];
+		uint64_t pawn[2][64];
+		uint64_t rookRays[64];
+		uint64_t bishopRays[64];
+		uint64_t between[64][64];
+		uint64_t line[64][64];
+	};
+
+	static const AttackTables tables;
+
+	static constexpr AttackTables buildAttackTables();
+	static constexpr uint64_t slidingAttacks( const int index , const uint64_t occupancy , const int directions[4][2] );
+	static void initMagics( Magic* magics , uint64_t* table , const int directions[4][2] );
+};
@@ -26,16 +26,15 @@ use at own risk
 
 #include "lchessBoard.hpp"
 #include <cstring>
-
-
-std::vector< lchessMove > lchessBoard::possibleMoves;
-uint lchessBoard::numberOfPossibleMoves;
+#include <sstream>
+#include <cctype>
+#include <cassert>
 
 
 
 lchessBoard::lchessBoard()
 {
-
+	this->network = nullptr;
 }
 
 
@@ -50,33 +49,39 @@ lchessBoard::~lchessBoard()
 void lchessBoard::init()
 {
     memset( this->board , EMPTY , 64 );
+	memset( this->pieceBitboards , 0 , sizeof( this->pieceBitboards ) );
+	memset( this->colorBitboards , 0 , sizeof( this->colorBitboards ) );
+	this->kingSquares[0] = NO_SQUARE;
+	this->kingSquares[1] = NO_SQUARE;
+	this->hash = 0;
+	this->materialKey = 0;
+	this->middleGameScore = 0;
+	this->endGameScore = 0;
+	this->gamePhase = 0;
 
 	// white pieces
-    this->board[0] = WHITE_ROOK;
-    this->board[1] = WHITE_KNIGHT;
-    this->board[2] = WHITE_BISHOP;
-    this->board[3] = WHITE_QUEEN;
-    this->board[4] = WHITE_KING;
-    this->board[5] = WHITE_BISHOP;
-    this->board[6] = WHITE_KNIGHT;
-    this->board[7] = WHITE_ROOK;
+    this->putPiece( 0 , WHITE_ROOK );
+    this->putPiece( 1 , WHITE_KNIGHT );
+    this->putPiece( 2 , WHITE_BISHOP );
+    this->putPiece( 3 , WHITE_QUEEN );
+    this->putPiece( 4 , WHITE_KING );
+    this->putPiece( 5 , WHITE_BISHOP );
+    this->putPiece( 6 , WHITE_KNIGHT );
+    this->putPiece( 7 , WHITE_ROOK );
 	// white pawns
-    for ( int i = 8 ; i < 16 ; ++i ) this->board[i] = WHITE_PAWN;
+    for ( int i = 8 ; i < 16 ; ++i ) this->putPiece( i , WHITE_PAWN );
 
 	// black pawns
-    for ( int i = 48 ; i < 56 ; ++i ) this->board[i] = BLACK_PAWN;
+    for ( int i = 48 ; i < 56 ; ++i ) this->putPiece( i , BLACK_PAWN );
 	// black pieces
-    this->board[56] = BLACK_ROOK;
-    this->board[57] = BLACK_KNIGHT;
-    this->board[58] = BLACK_BISHOP;
-    this->board[59] = BLACK_QUEEN;
-    this->board[60] = BLACK_KING;
-    this->board[61] = BLACK_BISHOP;
-    this->board[62] = BLACK_KNIGHT;
-    this->board[63] = BLACK_ROOK;
-
-	// initialize the threat map
-	this->threatMap = lchessThreatMap::fromBoard( *this );
+    this->putPiece( 56 , BLACK_ROOK );
+    this->putPiece( 57 , BLACK_KNIGHT );
+    this->putPiece( 58 , BLACK_BISHOP );
+    this->putPiece( 59 , BLACK_QUEEN );
+    this->putPiece( 60 , BLACK_KING );
+    this->putPiece( 61 , BLACK_BISHOP );
+    this->putPiece( 62 , BLACK_KNIGHT );
+    this->putPiece( 63 , BLACK_ROOK );
 
 	// reset the castle moves
 	this->b_whiteKingMoved = false;
@@ -94,643 +99,266 @@ void lchessBoard::init()
 	}
 
 	this->gameState = lchessGameState::ONGOING;
+	this->sideToMove = WHITE;
+	this->undoCount = 0;
+	this->historyCount = 0;
+	this->halfmoveClock = 0;
+	this->hash = this->computeHash();
+	this->refreshAccumulator();
 }
 
 
 
-void lchessBoard::getLegalMoves( std::vector< lchessMove >& moves , int& numberOfMoves , const BYTE color )
+bool lchessBoard::loadFen( const std::string& fen )
 {
-	Timer timer;
-	timer.start();
-
-
-	// reset the en passant moves
-	if ( color == WHITE )
+	std::istringstream stream( fen );
+	std::string placement , side , castling , enPassant;
+	int halfmoves = 0;
+	stream >> placement >> side >> castling >> enPassant;
+	// the move counters are optional
+	if ( !( stream >> halfmoves ) || halfmoves < 0 ) halfmoves = 0;
+	if ( placement.empty() || ( side != "w" && side != "b" ) )
 	{
-		for ( int i = 0 ; i < 8 ; ++i )
-		{
-			this->b_whitePawnMoved[i] = false;
-		}
+		std::cout << "lchessBoard > loadFen > could not read fen: " << fen << std::endl;
+		return false;
 	}
-	else if ( color == BLACK )
+
+	memset( this->board , EMPTY , 64 );
+	memset( this->pieceBitboards , 0 , sizeof( this->pieceBitboards ) );
+	memset( this->colorBitboards , 0 , sizeof( this->colorBitboards ) );
+	this->kingSquares[0] = NO_SQUARE;
+	this->kingSquares[1] = NO_SQUARE;
+	this->hash = 0;
+	this->materialKey = 0;
+	this->middleGameScore = 0;
+	this->endGameScore = 0;
+	this->gamePhase = 0;
+
+	// the piece types are the positions in this string
+	static const std::string pieceChars = "prnbqk";
+	int x = 0;
+	int y = 7;
+	for ( const char c : placement )
 	{
-		for ( int i = 0 ; i < 8 ; ++i )
+		if ( c == '/' )
 		{
-			this->b_blackPawnMoved[i] = false;
+			--y;
+			x = 0;
+			continue;
 		}
-	}
-
-	// count pieces for both colors because king vs king is always a draw
-	int numberOfColor1Pieces = 0;
-	int numberOfColor2Pieces = 0;
-
-	// find all possible moves, this may include some illegal moves that have to be removed later
-	numberOfPossibleMoves = 0;
-	for ( int i = 0 ; i < 64 ; ++i )
-	{
-		BYTE piece = this->board[i];
-		int x = this->toX(i);
-		int y = this->toY(i);
-		if ( this->getColor( x , y ) == color )
+		if ( c >= '1' && c <= '8' )
 		{
-			++numberOfColor1Pieces;
-			if ( piece == WHITE_PAWN )
-			{
-				// 1 square up
-				if ( i+8 < 64 && this->board[i+8] == EMPTY )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , i+8 , WHITE_PAWN );
-				}
-				// 2 squares up
-				if ( y == 1 && this->board[i+16] == EMPTY )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , i+16 , WHITE_PAWN );
-				}
-				// captures
-				if ( y+1 < 8 && x-1 >= 0 && this->isBlack( (y+1)*8+(x-1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x-1) , WHITE_PAWN );
-				}
-				if ( y+1 < 8 && x+1 < 8 && this->isBlack( (y+1)*8+(x+1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x+1) , WHITE_PAWN );
-				}
-				// en passant
-				if ( y == 4 )
-				{
-					if ( x-1 >= 0 && this->b_blackPawnMoved[x-1] )
-					{
-						possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x-1) , WHITE_PAWN , true );
-					}
-					if ( x+1 < 8 && this->b_blackPawnMoved[x+1] )
-					{
-						possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x+1) , WHITE_PAWN , true );
-					}
-				}
-			}
-			else if ( piece == BLACK_PAWN )
-			{
-				// 1 square down
-				if ( i-8 >= 0 && this->board[i-8] == EMPTY )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , i-8 , BLACK_PAWN );
-				}
-				// 2 squares down
-				if ( y == 6 && this->board[i-16] == EMPTY )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , i-16 , BLACK_PAWN );
-				}
-				// captures
-				if ( y-1 >= 0 && x-1 >= 0 && this->isWhite( (y-1)*8+(x-1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x-1) , BLACK_PAWN );
-				}
-				if ( y-1 >= 0 && x+1 < 8 && this->isWhite( (y-1)*8+(x+1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x+1) , BLACK_PAWN );
-				}
-				// en passant
-				if ( y == 3 )
-				{
-					if ( x-1 >= 0 && this->b_whitePawnMoved[x-1] )
-					{
-						possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x-1) , BLACK_PAWN , true );
-					}
-					if ( x+1 < 8 && this->b_whitePawnMoved[x+1] )
-					{
-						possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x+1) , BLACK_PAWN , true );
-					}
-				}
-			}
-			else if ( piece == WHITE_KNIGHT || piece == BLACK_KNIGHT )
-			{
-				// down
-				if ( x-1 >= 0 && y-2 >= 0 && this->getColor( x-1 , y-2 ) != color )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-2)*8+(x-1) , piece );
-				}
-				if ( x+1 < 8 && y-2 >= 0 && this->getColor( x+1 , y-2 ) != color )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-2)*8+(x+1) , piece );
-				}
-				// up
-				if ( x-1 >= 0 && y+2 < 8 && this->getColor( x-1 , y+2 ) != color )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+2)*8+(x-1) , piece );
-				}
-				if ( x+1 < 8 && y+2 < 8 && this->getColor( x+1 , y+2 ) != color )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+2)*8+(x+1) , piece );
-				}
-				// left
-				if ( x-2 >= 0 && y-1 >= 0 && this->getColor( x-2 , y-1 ) != color )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x-2) , piece );
-				}
-				if ( x-2 >= 0 && y+1 < 8 && this->getColor( x-2 , y+1 ) != color )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x-2) , piece );
-				}
-				// right
-				if ( x+2 < 8 && y-1 >= 0 && this->getColor( x+2 , y-1 ) != color )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x+2) , piece );
-				}
-				if ( x+2 < 8 && y+1 < 8 && this->getColor( x+2 , y+1 ) != color )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x+2) , piece );
-				}
-			}
-			else if ( piece == WHITE_ROOK || piece == WHITE_BISHOP || piece == WHITE_QUEEN || piece == BLACK_ROOK || piece == BLACK_BISHOP || piece == BLACK_QUEEN )
-			{
-				// rook moves
-				if ( piece == WHITE_ROOK || piece == WHITE_QUEEN || piece == BLACK_ROOK || piece == BLACK_QUEEN )
-				{
-					// down
-					for ( int r = y-1 ; r >= 0 ; --r )
-					{
-						// stop at pieces with the same color
-						if ( this->getColor( x , r ) == color ) break;
-						possibleMoves[numberOfPossibleMoves++].update( i , r*8+x , piece );
-						// stop at enemy pieces
-						if ( this->getColor( x , r ) != EMPTY && this->getColor( x , r ) != color ) break;
-					}
-					// up
-					for ( int r = y+1 ; r < 8 ; ++r )
-					{
-						// stop at pieces with the same color
-						if ( this->getColor( x , r ) == color ) break;
-						possibleMoves[numberOfPossibleMoves++].update( i , r*8+x , piece );
-						// stop at enemy pieces
-						if ( this->getColor( x , r ) != EMPTY && this->getColor( x , r ) != color ) break;
-					}
-					// left
-					for ( int f = x-1 ; f >= 0 ; --f )
-					{
-						// stop at pieces with the same color
-						if ( this->getColor( f , y ) == color ) break;
-						possibleMoves[numberOfPossibleMoves++].update( i , y*8+f , piece );
-						// stop at enemy pieces
-						if ( this->getColor( f , y ) != EMPTY && this->getColor( f , y ) != color ) break;
-					}
-					// right
-					for ( int f = x+1 ; f < 8 ; ++f )
-					{
-						// stop at pieces with the same color
-						if ( this->getColor( f , y ) == color ) break;
-						possibleMoves[numberOfPossibleMoves++].update( i , y*8+f , piece );
-						// stop at enemy pieces
-						if ( this->getColor( f , y ) != EMPTY && this->getColor( f , y ) != color ) break;
-					}
-				}
-				// bishop moves
-				if ( piece == WHITE_BISHOP || piece == WHITE_QUEEN || piece == BLACK_BISHOP || piece == BLACK_QUEEN )
-				{
-					// down left
-					for ( int r = y-1 , f = x-1 ; r >= 0 && f >= 0 ; --r , --f )
-					{
-						// stop at pieces with the same color
-						if ( this->getColor( f , r ) == color ) break;
-						possibleMoves[numberOfPossibleMoves++].update( i , r*8+f , piece );
-						// stop at enemy pieces
-						if ( this->getColor( f , r ) != EMPTY && this->getColor( f , r ) != color ) break;
-					}
-					// down right
-					for ( int r = y-1 , f = x+1 ; r >= 0 && f < 8 ; --r , ++f )
-					{
-						// stop at pieces with the same color
-						if ( this->getColor( f , r ) == color ) break;
-						possibleMoves[numberOfPossibleMoves++].update( i , r*8+f , piece );
-						// stop at enemy pieces
-						if ( this->getColor( f , r ) != EMPTY && this->getColor( f , r ) != color ) break;
-					}
-					// up left
-					for ( int r = y+1 , f = x-1 ; r < 8 && f >= 0 ; ++r , --f )
-					{
-						// stop at pieces with the same color
-						if ( this->getColor( f , r ) == color ) break;
-						possibleMoves[numberOfPossibleMoves++].update( i , r*8+f , piece );
-						// stop at enemy pieces
-						if ( this->getColor( f , r ) != EMPTY && this->getColor( f , r ) != color ) break;
-					}
-					// up right
-					for ( int r = y+1 , f = x+1 ; r < 8 && f < 8 ; ++r , ++f )
-					{
-						// stop at pieces with the same color
-						if ( this->getColor( f , r ) == color ) break;
-						possibleMoves[numberOfPossibleMoves++].update( i , r*8+f , piece );
-						// stop at enemy pieces
-						if ( this->getColor( f , r ) != EMPTY && this->getColor( f , r ) != color ) break;
-					}
-				}
-			}
-			else if ( piece == WHITE_KING )
-			{
-				// straight moves
-				if ( y-1 >= 0 && !this->isWhite( (y-1)*8+x ) && !this->threatMap.isBlackThreat( (y-1)*8+x ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+x , WHITE_KING );
-				}
-				if ( y+1 < 8 && !this->isWhite( (y+1)*8+x ) && !this->threatMap.isBlackThreat( (y+1)*8+x ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+x , WHITE_KING );
-				}
-				if ( x-1 >= 0 && !this->isWhite( y*8+(x-1) ) && !this->threatMap.isBlackThreat( y*8+(x-1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , y*8+(x-1) , WHITE_KING );
-				}
-				if ( x+1 < 8 && !this->isWhite( y*8+(x+1) ) && !this->threatMap.isBlackThreat( y*8+(x+1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , y*8+(x+1) , WHITE_KING );
-				}
-
-				// diagonal moves
-				if ( y-1 >= 0 && x-1 >= 0 && !this->isWhite( (y-1)*8+(x-1) ) && !this->threatMap.isBlackThreat( (y-1)*8+(x-1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x-1) , WHITE_KING );
-				}
-				if ( y-1 >= 0 && x+1 < 8 && !this->isWhite( (y-1)*8+(x+1) ) && !this->threatMap.isBlackThreat( (y-1)*8+(x+1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x+1) , WHITE_KING );
-				}
-				if ( y+1 < 8 && x-1 >= 0 && !this->isWhite( (y+1)*8+(x-1) ) && !this->threatMap.isBlackThreat( (y+1)*8+(x-1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x-1) , WHITE_KING );
-				}
-				if ( y+1 < 8 && x+1 < 8 && !this->isWhite( (y+1)*8+(x+1) ) && !this->threatMap.isBlackThreat( (y+1)*8+(x+1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x+1) , WHITE_KING );
-				}
-
-				// castles
-				if ( !this->b_whiteKingMoved )
-				{
-					// queen side castle
-					if ( !this->b_a1RookMoved && this->getPiece(0) == WHITE_ROOK )
-					{
-						// are the squares empty
-						if ( this->isEmpty( 1 ) && this->isEmpty( 2 ) && this->isEmpty( 3 ) )
-						{
-							// is none of the squares under attack by black
-							if ( !this->threatMap.isBlackThreat( 2 ) && !this->threatMap.isBlackThreat( 3 ) && !this->threatMap.isBlackThreat( 4 ) )
-							{
-								possibleMoves[numberOfPossibleMoves++].update( i , 2 , WHITE_KING );
-							}
-						}
-					}
-					// king side castle
-					if ( !this->b_h1RookMoved && this->getPiece(7) == WHITE_ROOK )
-					{
-						// are the squares empty
-						if ( this->isEmpty( 5 ) && this->isEmpty( 6 ) )
-						{
-							// is none of the squares under attack by black
-							if ( !this->threatMap.isBlackThreat( 4 ) && !this->threatMap.isBlackThreat( 5 ) && !this->threatMap.isBlackThreat( 6 ) )
-							{
-								possibleMoves[numberOfPossibleMoves++].update( i , 6 , WHITE_KING );
-							}
-						}
-					}
-				}
-			}
-			else if ( piece == BLACK_KING )
-			{
-				// straight moves
-				if ( y-1 >= 0 && !this->isBlack( (y-1)*8+x ) && !this->threatMap.isWhiteThreat( (y-1)*8+x ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+x , BLACK_KING );
-				}
-				if ( y+1 < 8 && !this->isBlack( (y+1)*8+x ) && !this->threatMap.isWhiteThreat( (y+1)*8+x ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+x , BLACK_KING );
-				}
-				if ( x-1 >= 0 && !this->isBlack( y*8+(x-1) ) && !this->threatMap.isWhiteThreat( y*8+(x-1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , y*8+(x-1) , BLACK_KING );
-				}
-				if ( x+1 < 8 && !this->isBlack( y*8+(x+1) ) && !this->threatMap.isWhiteThreat( y*8+(x+1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , y*8+(x+1) , BLACK_KING );
-				}
-
-				// diagonal moves
-				if ( y-1 >= 0 && x-1 >= 0 && !this->isBlack( (y-1)*8+(x-1) ) && !this->threatMap.isWhiteThreat( (y-1)*8+(x-1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x-1) , BLACK_KING );
-				}
-				if ( y-1 >= 0 && x+1 < 8 && !this->isBlack( (y-1)*8+(x+1) ) && !this->threatMap.isWhiteThreat( (y-1)*8+(x+1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y-1)*8+(x+1) , BLACK_KING );
-				}
-				if ( y+1 < 8 && x-1 >= 0 && !this->isBlack( (y+1)*8+(x-1) ) && !this->threatMap.isWhiteThreat( (y+1)*8+(x-1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x-1) , BLACK_KING );
-				}
-				if ( y+1 < 8 && x+1 < 8 && !this->isBlack( (y+1)*8+(x+1) ) && !this->threatMap.isWhiteThreat( (y+1)*8+(x+1) ) )
-				{
-					possibleMoves[numberOfPossibleMoves++].update( i , (y+1)*8+(x+1) , BLACK_KING );
-				}
-
-				// castles
-				if ( !this->b_blackKingMoved )
-				{
-					// queen side castle
-					if ( !this->b_a8RookMoved && this->getPiece(56) == BLACK_ROOK )
-					{
-						// are the squares empty
-						if ( this->isEmpty( 57 ) && this->isEmpty( 58 ) && this->isEmpty( 59 ) )
-						{
-							// is none of the squares under attack by white
-							if ( !this->threatMap.isWhiteThreat( 58 ) && !this->threatMap.isWhiteThreat( 59 ) && !this->threatMap.isWhiteThreat( 60 ) )
-							{
-								possibleMoves[numberOfPossibleMoves++].update( i , 58 , BLACK_KING );
-							}
-						}
-					}
-					// king side castle
-					if ( !this->b_h8RookMoved && this->getPiece(63) == BLACK_ROOK )
-					{
-						// are the squares empty
-						if ( this->isEmpty( 61 ) && this->isEmpty( 62 ) )
-						{
-							// is none of the squares under attack by white
-							if ( !this->threatMap.isWhiteThreat( 60 ) && !this->threatMap.isWhiteThreat( 61 ) && !this->threatMap.isWhiteThreat( 62 ) )
-							{
-								possibleMoves[numberOfPossibleMoves++].update( i , 62 , BLACK_KING );
-							}
-						}
-					}
-				}
-			}
+			x += c-'0';
+			continue;
 		}
-		else if ( this->getColor( x , y ) != EMPTY )
+		const size_t type = pieceChars.find( char( tolower( c ) ) );
+		if ( type == std::string::npos || x > 7 || y < 0 )
 		{
-			++numberOfColor2Pieces;
+			std::cout << "lchessBoard > loadFen > could not read fen: " << fen << std::endl;
+			this->init();
+			return false;
 		}
+		this->putPiece( y*8+x , BYTE( ( isupper( c ) ? WHITE : BLACK ) | type ) );
+		++x;
 	}
 
-	// remove all illegal moves
-	if ( color == WHITE )
+	this->sideToMove = ( side == "w" ) ? WHITE : BLACK;
+
+	// a missing castle right is stored as a moved king or rook
+	this->b_whiteKingMoved = castling.find_first_of( "KQ" ) == std::string::npos;
+	this->b_blackKingMoved = castling.find_first_of( "kq" ) == std::string::npos;
+	this->b_h1RookMoved = castling.find( 'K' ) == std::string::npos;
+	this->b_a1RookMoved = castling.find( 'Q' ) == std::string::npos;
+	this->b_h8RookMoved = castling.find( 'k' ) == std::string::npos;
+	this->b_a8RookMoved = castling.find( 'q' ) == std::string::npos;
+
+	// the en passant square belongs to the pawn of the side that moved last
+	for ( int i = 0 ; i < 8 ; ++i )
 	{
-		numberOfMoves = 0;
-		for ( uint i = 0 ; i < numberOfPossibleMoves ; ++i )
-		{
-			// castling moves already cannot happen if the king is in check or if the king would end up in check
-			if ( possibleMoves[i].isCastle() )
-			{
-				moves[numberOfMoves++].update( possibleMoves[i] );	
-			}
-			else
-			{
-				// do the move temporarily
-				BYTE oldToSquare = this->board[this->possibleMoves[i].to];
-				if ( this->possibleMoves[i].piece == WHITE_PAWN && this->possibleMoves[i].enPassant )
-				{
-					this->board[this->possibleMoves[i].from] = EMPTY;
-					this->board[this->possibleMoves[i].to] = WHITE_PAWN;
-					// remove the black pawn
-					this->board[this->possibleMoves[i].fromY()*8+this->possibleMoves[i].toX()] = EMPTY;
-				}
-				else
-				{
-					this->board[this->possibleMoves[i].from] = EMPTY;
-					this->board[this->possibleMoves[i].to] = this->possibleMoves[i].piece;
-				}
-
-				// check whether the white king is in check
-				if ( !lchessThreatMap::isWhiteInCheck( *this ) )
-				{
-					moves[numberOfMoves++].update( possibleMoves[i] );	
-				}
-
-				//// calculate the threat map of the new position
-				//this->threatMap = lchessThreatMap::fromBoard( *this );
-
-				//// if white is not in check it is a legal move
-				//if ( !this->isWhiteInCheck() )
-				//{
-				//	moves[numberOfMoves++].update( possibleMoves[i] );	
-				//}
-
-				// undo the move
-				if ( this->possibleMoves[i].piece == WHITE_PAWN && this->possibleMoves[i].enPassant )
-				{
-					this->board[this->possibleMoves[i].from] = this->possibleMoves[i].piece;
-					this->board[this->possibleMoves[i].to] = oldToSquare;
-					// restore the black pawn
-					this->board[this->possibleMoves[i].fromY()*8+this->possibleMoves[i].toX()] = BLACK_PAWN;
-				}
-				else
-				{
-					this->board[this->possibleMoves[i].from] = this->possibleMoves[i].piece;
-					this->board[this->possibleMoves[i].to] = oldToSquare;
-				}
-			}
-		}
+		this->b_whitePawnMoved[i] = false;
+		this->b_blackPawnMoved[i] = false;
 	}
-	/*
-	BLACK
-	*/
-	else if ( color == BLACK )
+	if ( enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' )
 	{
-		numberOfMoves = 0;
-		for ( uint i = 0 ; i < numberOfPossibleMoves ; ++i )
-		{
-			// castling moves already cannot happen if the king is in check or if the king would end up in check
-			if ( possibleMoves[i].isCastle() )
-			{
-				moves[numberOfMoves++].update( possibleMoves[i] );	
-			}
-			else
-			{
-				// do the move temporarily
-				BYTE oldToSquare = this->board[this->possibleMoves[i].to];
-				if ( this->possibleMoves[i].piece == BLACK_PAWN && this->possibleMoves[i].enPassant )
-				{
-					this->board[this->possibleMoves[i].from] = EMPTY;
-					this->board[this->possibleMoves[i].to] = BLACK_PAWN;
-					// remove the white pawn
-					this->board[this->possibleMoves[i].fromY()*8+this->possibleMoves[i].toX()] = EMPTY;
-				}
-				else
-				{
-					this->board[this->possibleMoves[i].from] = EMPTY;
-					this->board[this->possibleMoves[i].to] = this->possibleMoves[i].piece;
-				}
-
-				// check whether the black king is in check
-				if ( !lchessThreatMap::isBlackInCheck( *this ) )
-				{
-					moves[numberOfMoves++].update( possibleMoves[i] );	
-				}
-
-				//// calculate the threat map of the new position
-				//this->threatMap = lchessThreatMap::fromBoard( *this );
-
-				//// if white is not in check it is a legal move
-				//if ( !this->isBlackInCheck() )
-				//{
-				//	moves[numberOfMoves++].update( possibleMoves[i] );	
-				//}
-
-				// undo the move
-				if ( this->possibleMoves[i].piece == BLACK_PAWN && this->possibleMoves[i].enPassant )
-				{
-					this->board[this->possibleMoves[i].from] = this->possibleMoves[i].piece;
-					this->board[this->possibleMoves[i].to] = oldToSquare;
-					// restore the white pawn
-					this->board[this->possibleMoves[i].fromY()*8+this->possibleMoves[i].toX()] = WHITE_PAWN;
-				}
-				else
-				{
-					this->board[this->possibleMoves[i].from] = this->possibleMoves[i].piece;
-					this->board[this->possibleMoves[i].to] = oldToSquare;
-				}
-			}
-		}
+		if ( this->sideToMove == WHITE ) this->b_blackPawnMoved[enPassant[0]-'a'] = true;
+		else this->b_whitePawnMoved[enPassant[0]-'a'] = true;
 	}
 
-	//// reset the threat map to the current position again
-	//this->threatMap = lchessThreatMap::fromBoard( *this );
+	this->gameState = lchessGameState::ONGOING;
+	this->undoCount = 0;
+	this->historyCount = 0;
+	this->halfmoveClock = halfmoves;
+	this->hash = this->computeHash();
+	this->refreshAccumulator();
+	return true;
+}
 
 
+
+void lchessBoard::getLegalMoves( lchessMoveList& moves , const BYTE color )
+{
+	moves.clear();
+
+	if ( this->getKingSquare( color ) == NO_SQUARE )
+	{
+		reportError( REASON_NO_KING , color );
+		return;
+	}
+
+	// the color is only branched on once, everything below is specialized at compile time
+	if ( color == WHITE ) this->generateLegalMoves< WHITE >( moves );
+	else this->generateLegalMoves< BLACK >( moves );
+
+	LCHESS_MEASURE( PHASE_GAME_STATE );
+
 	// check mate detection
-	if ( color == WHITE )
+	if ( moves.empty() )
 	{
-		if ( numberOfMoves == 0 )
+		if ( ( color == WHITE ) ? this->isInCheck< WHITE >() : this->isInCheck< BLACK >() )
 		{
-			if ( this->isWhiteInCheck() )
-			{
-				this->gameState = lchessGameState::BLACKWIN;
-				std::cout << "WHITE IS CHECKMATE" << std::endl;
-
-			}
-			else
-			{
-				this->gameState = lchessGameState::DRAW;
-				std::cout << "DRAW" << std::endl;
-			}
+			this->setGameState( ( color == WHITE ) ? lchessGameState::BLACKWIN : lchessGameState::WHITEWIN , REASON_CHECKMATE , color );
 		}
-	}
-	else if ( color == BLACK )
-	{
-		if ( numberOfMoves == 0 )
+		else
 		{
-			if ( this->isBlackInCheck() )
-			{
-				this->gameState = lchessGameState::WHITEWIN;
-				std::cout << "BLACK IS CHECKMATE" << std::endl;
-			}
-			else
-			{
-				this->gameState = lchessGameState::DRAW;
-				std::cout << "DRAW" << std::endl;
-			}
+			this->setGameState( lchessGameState::DRAW , REASON_STALEMATE , color );
 		}
 	}
+	// a mate on the last move before the fifty move rule still counts
+	else if ( this->halfmoveClock >= 100 )
+	{
+		this->setGameState( lchessGameState::DRAW , REASON_FIFTY_MOVES , color );
+	}
+	else if ( this->isRepetition( 2 ) )
+	{
+		this->setGameState( lchessGameState::DRAW , REASON_REPETITION , color );
+	}
 
-	if ( numberOfColor1Pieces == 1 && numberOfColor2Pieces == 1 )
+	// king vs king is always a draw, the material key answers this without counting pieces
+	if ( this->materialKey == ( materialBit( WHITE_KING ) | materialBit( BLACK_KING ) ) )
+	{
+		this->setGameState( lchessGameState::DRAW , REASON_KING_VS_KING , color );
+	}
+	else if ( this->isInsufficientMaterial() )
 	{
-		this->gameState = lchessGameState::DRAW;
-		std::cout << "DRAW (king vs king)" << std::endl;
+		this->setGameState( lchessGameState::DRAW , REASON_INSUFFICIENT_MATERIAL , color );
 	}
+}
+
+
 
-	// timer.stop();
-	std::cout << timer.getTime() << "ms" << std::endl;
+void lchessBoard::generateMoves( lchessMoveList& moves ) const
+{
+	moves.clear();
+	if ( this->getKingSquare( this->sideToMove ) == NO_SQUARE ) return;
+
+	if ( this->sideToMove == WHITE ) this->generateLegalMoves< WHITE >( moves );
+	else this->generateLegalMoves< BLACK >( moves );
 }
 
 
 
-int lchessBoard::evaluatePosition() const
+int lchessBoard::computeEvaluation() const
 {
-	int whiteCounter = 0;
-	int blackCounter = 0;
-	for ( int i = 0 ; i < 64 ; ++i )
+	if ( this->network )
 	{
-		switch ( this->board[i] )
-		{
-		case WHITE_PAWN: whiteCounter += 1; break;
-		case WHITE_ROOK: whiteCounter += 5; break;
-		case WHITE_KNIGHT: whiteCounter += 3; break;
-		case WHITE_BISHOP: whiteCounter += 3; break;
-		case WHITE_QUEEN: whiteCounter += 9; break;
-		case WHITE_KING: whiteCounter += 1000; break;
-		case BLACK_PAWN: blackCounter += 1; break;
-		case BLACK_ROOK: blackCounter += 5; break;
-		case BLACK_KNIGHT: blackCounter += 3; break;
-		case BLACK_BISHOP: blackCounter += 3; break;
-		case BLACK_QUEEN: blackCounter += 9; break;
-		case BLACK_KING: blackCounter += 1000; break;
-		}
+		lchessAccumulator accumulator;
+		this->network->refresh( accumulator , 0 , *this );
+		this->network->refresh( accumulator , 1 , *this );
+		const int score = std::min( std::max( this->network->evaluate( accumulator , this->sideToMove ) , -MAX_EVALUATION ) , MAX_EVALUATION );
+		return ( this->sideToMove == WHITE ) ? score : -score;
+	}
+
+	int middleGame = 0;
+	int endGame = 0;
+	int phase = 0;
+	uint64_t pieces = this->getOccupied();
+	while ( pieces )
+	{
+		const int index = lchessBitboard::popLsb( pieces );
+		middleGame += lchessEvaluation::middleGame( this->board[index] , index );
+		endGame += lchessEvaluation::endGame( this->board[index] , index );
+		phase += lchessEvaluation::phase( this->board[index] );
 	}
-	return whiteCounter - blackCounter;
+	return lchessEvaluation::taper( middleGame , endGame , phase );
+}
+
+
+
+void lchessBoard::setNetwork( const lchessNetwork* network )
+{
+	this->network = ( network && network->isLoaded() ) ? network : nullptr;
+	this->refreshAccumulator();
 }
 
 
 
 void lchessBoard::move( const lchessMove& move )
 {
+	// remember the position for the repetition detection, a capture or pawn move can not be taken back so it
+	// restarts the fifty move count
+	this->hashHistory[this->historyCount++ & ( HASH_HISTORY_SIZE-1 )] = this->hash;
+	if ( ( move.piece & PIECE_TYPE_MASK ) == PAWN || !this->isEmpty( move.to ) ) this->halfmoveClock = 0;
+	else ++this->halfmoveClock;
+
+	// the pieces update the hash themselves, the rest of the position is taken out here and put back in at the end
+	this->hash ^= this->stateHash();
+
 	// castles
 	if ( move.piece == WHITE_KING && move.from == 4 && move.to == 2 )
 	{
-		this->board[4] = EMPTY;
-		this->board[0] = EMPTY;
-		this->board[2] = WHITE_KING;
-		this->board[3] = WHITE_ROOK;
+		this->movePiece( 4 , 2 );
+		this->movePiece( 0 , 3 );
 	}
 	else if ( move.piece == WHITE_KING && move.from == 4 && move.to == 6 )
 	{
-		this->board[4] = EMPTY;
-		this->board[7] = EMPTY;
-		this->board[6] = WHITE_KING;
-		this->board[5] = WHITE_ROOK;
+		this->movePiece( 4 , 6 );
+		this->movePiece( 7 , 5 );
 	}
 	else if ( move.piece == BLACK_KING && move.from == 60 && move.to == 58 )
 	{
-		this->board[60] = EMPTY;
-		this->board[56] = EMPTY;
-		this->board[58] = BLACK_KING;
-		this->board[59] = BLACK_ROOK;
+		this->movePiece( 60 , 58 );
+		this->movePiece( 56 , 59 );
 	}
 	else if ( move.piece == BLACK_KING && move.from == 60 && move.to == 62 )
 	{
-		this->board[60] = EMPTY;
-		this->board[63] = EMPTY;
-		this->board[62] = BLACK_KING;
-		this->board[61] = BLACK_ROOK;
+		this->movePiece( 60 , 62 );
+		this->movePiece( 63 , 61 );
 	}
 	// en passant
-	else if ( move.piece == WHITE_PAWN && move.enPassant )
-	{
-		this->board[move.from] = EMPTY;
-		this->board[move.to] = WHITE_PAWN;
-		// remove the black pawn
-		this->board[move.fromY()*8+move.toX()] = EMPTY;
-	}
-	else if ( move.piece == BLACK_PAWN && move.enPassant )
+	else if ( ( move.piece == WHITE_PAWN || move.piece == BLACK_PAWN ) && move.enPassant )
 	{
-		this->board[move.from] = EMPTY;
-		this->board[move.to] = BLACK_PAWN;
-		// remove the white pawn
-		this->board[move.fromY()*8+move.toX()] = EMPTY;
+		this->movePiece( move.from , move.to );
+		// remove the captured pawn
+		this->removePiece( move.fromY()*8+move.toX() );
 	}
 	else
 	{
-		this->board[move.from] = EMPTY;
-		this->board[move.to] = move.piece;
+		if ( !this->isEmpty( move.to ) ) this->removePiece( move.to );
+		this->movePiece( move.from , move.to );
 
-		// auto queen promotion
-		if ( move.piece == WHITE_PAWN && move.toY() == 7 ) this->board[move.to] = WHITE_QUEEN;
-		if ( move.piece == BLACK_PAWN && move.toY() == 0 ) this->board[move.to] = BLACK_QUEEN;
+		// promotion, a move without a promotion piece promotes to a queen
+		if ( move.isPromotion() )
+		{
+			this->removePiece( move.to );
+			this->putPiece( move.to , move.resultingPiece() );
+		}
 	}
 
+	// a rook captured on its corner can not castle anymore either
 	if ( move.from == 4 ) this->b_whiteKingMoved = true;
-	if ( move.from == 0 ) this->b_a1RookMoved = true;
-	if ( move.from == 7 ) this->b_h1RookMoved = true;
+	if ( move.from == 0 || move.to == 0 ) this->b_a1RookMoved = true;
+	if ( move.from == 7 || move.to == 7 ) this->b_h1RookMoved = true;
 
 	if ( move.from == 60 ) this->b_blackKingMoved = true;
-	if ( move.from == 56 ) this->b_a8RookMoved = true;
-	if ( move.from == 63 ) this->b_h8RookMoved = true;
+	if ( move.from == 56 || move.to == 56 ) this->b_a8RookMoved = true;
+	if ( move.from == 63 || move.to == 63 ) this->b_h8RookMoved = true;
+
+	// the en passant flags of the other color were only valid for this move
+	bool* enemyPawnMoved = ( ( move.piece & PIECE_COLOR_MASK ) == WHITE ) ? this->b_blackPawnMoved : this->b_whitePawnMoved;
+	for ( int i = 0 ; i < 8 ; ++i )
+	{
+		enemyPawnMoved[i] = false;
+	}
 
 	// set en passant flags to true if the pawn has moved 2 squares
 	if ( move.piece == WHITE_PAWN && move.fromY() == 1 && move.toY() == 3 )
@@ -742,22 +370,93 @@ void lchessBoard::move( const lchessMove& move )
 		this->b_blackPawnMoved[move.fromX()] = true;
 	}
 
-	// recalculate threat map
-	this->threatMap = lchessThreatMap::fromBoard( *this );
+	this->sideToMove = ( ( move.piece & PIECE_COLOR_MASK ) == WHITE ) ? BLACK : WHITE;
+	this->hash ^= this->stateHash();
+#ifdef LCHESS_DEBUG_CHECKS
+	assert( this->hash == this->computeHash() );
+	assert( this->evaluatePosition() == this->computeEvaluation() );
+#endif
+}
+
+
+
+bool lchessBoard::makeMove( const lchessMove& move )
+{
+	if ( this->undoCount >= MAX_UNDO_MOVES )
+	{
+		reportError( REASON_UNDO_STACK_FULL , move.piece & PIECE_COLOR_MASK );
+		return false;
+	}
+
+	lchessUndo& undo = this->undoStack[this->undoCount++];
+	undo.move = move.pack();
+	undo.piece = move.piece;
+	undo.captured = move.enPassant ? EMPTY : this->board[move.to];
+	undo.castlingFlags = this->getCastlingFlags();
+	undo.whitePawnMoved = packPawnMoved( this->b_whitePawnMoved );
+	undo.blackPawnMoved = packPawnMoved( this->b_blackPawnMoved );
+	undo.gameState = this->gameState;
+	undo.halfmoveClock = uint16_t( this->halfmoveClock );
+	undo.hash = this->hash;
+
+	this->move( move );
+	return true;
+}
+
+
+
+void lchessBoard::unmakeMove()
+{
+	assert( this->undoCount > 0 );
+	const lchessUndo& undo = this->undoStack[--this->undoCount];
+	lchessMove move;
+	move.update( undo.move.from() , undo.move.to() , undo.piece , undo.move.isEnPassant() );
+
+	if ( move.isCastle() )
+	{
+		// the rook stands next to the king on the side it castled to
+		const int rookFrom = ( move.to > move.from ) ? move.from+3 : move.from-4;
+		const int rookTo = ( move.to > move.from ) ? move.from+1 : move.from-1;
+		this->movePiece( move.to , move.from );
+		this->movePiece( rookTo , rookFrom );
+	}
+	else if ( move.enPassant )
+	{
+		const int capturedSquare = move.fromY()*8+move.toX();
+		this->movePiece( move.to , move.from );
+		this->putPiece( capturedSquare , ( move.piece == WHITE_PAWN ) ? BLACK_PAWN : WHITE_PAWN );
+	}
+	else
+	{
+		// the piece on the target square may have been promoted, so the original piece is put back
+		this->removePiece( move.to );
+		this->putPiece( move.from , move.piece );
+		if ( undo.captured != EMPTY ) this->putPiece( move.to , undo.captured );
+	}
+
+	this->setCastlingFlags( undo.castlingFlags );
+	unpackPawnMoved( this->b_whitePawnMoved , undo.whitePawnMoved );
+	unpackPawnMoved( this->b_blackPawnMoved , undo.blackPawnMoved );
+	this->gameState = lchessGameState( undo.gameState );
+	this->sideToMove = undo.piece & PIECE_COLOR_MASK;
+	this->hash = undo.hash;
+	this->halfmoveClock = undo.halfmoveClock;
+	--this->historyCount;
+#ifdef LCHESS_DEBUG_CHECKS
+	assert( this->hash == this->computeHash() );
+	assert( this->evaluatePosition() == this->computeEvaluation() );
+#endif
 }
 
 
 
 bool lchessBoard::isWhiteInCheck() const
 {
-	for ( int i = 0 ; i < 64 ; ++i )
+	if ( this->getKingSquare( WHITE ) != NO_SQUARE )
 	{
-		if ( this->board[i] == WHITE_KING )
-		{
-			return this->threatMap.isBlackThreat(i);
-		}
+		return this->attackersTo( this->getKingSquare( WHITE ) , BLACK ) != 0;
 	}
-	std::cout << "lchessBoard > isWhiteInCheck > no white king found, something is wrong" << std::endl;
+	reportError( REASON_NO_KING , WHITE );
 	return true;
 }
 
@@ -765,15 +464,120 @@ bool lchessBoard::isWhiteInCheck() const
 
 bool lchessBoard::isBlackInCheck() const
 {
-	for ( int i = 0 ; i < 64 ; ++i )
+	if ( this->getKingSquare( BLACK ) != NO_SQUARE )
 	{
-		if ( this->board[i] == BLACK_KING )
+		return this->attackersTo( this->getKingSquare( BLACK ) , WHITE ) != 0;
+	}
+	reportError( REASON_NO_KING , BLACK );
+	return true;
+}
+
+
+
+lchessMove lchessBoard::toMove( const lchessCompactMove move ) const
+{
+	const BYTE piece = this->board[move.from()];
+	lchessMove result;
+	result.update( move.from() , move.to() , piece , move.isEnPassant() , move.isPromotion() ? BYTE( ( piece & PIECE_COLOR_MASK ) | move.promotionType() ) : BYTE( EMPTY ) );
+	return result;
+}
+
+
+
+uint64_t lchessBoard::attackersTo( const int index , const BYTE color ) const
+{
+	return this->attackersTo( index , color , this->getOccupied() );
+}
+
+
+
+// knights, kings and pawns are found with their attack pattern from the target square, sliders with the first
+// blocker in each direction
+uint64_t lchessBoard::attackersTo( const int index , const BYTE color , const uint64_t occupancy ) const
+{
+	const uint64_t diagonal = this->getPieces( color | BISHOP ) | this->getPieces( color | QUEEN );
+	const uint64_t straight = this->getPieces( color | ROOK ) | this->getPieces( color | QUEEN );
+	return ( lchessBitboard::pawnAttacks( color == WHITE ? BLACK : WHITE , index ) & this->getPieces( color | PAWN ) )
+		| ( lchessBitboard::knightAttacks( index ) & this->getPieces( color | KNIGHT ) )
+		| ( lchessBitboard::kingAttacks( index ) & this->getPieces( color | KING ) )
+		| ( lchessBitboard::bishopAttacks( index , occupancy ) & diagonal )
+		| ( lchessBitboard::rookAttacks( index , occupancy ) & straight );
+}
+
+
+
+// the swap algorithm, gains[n] is what the side making the n-th capture wins if it is the last one, the list is then
+// folded back from the end with every side choosing between capturing and standing still
+int lchessBoard::staticExchange( const lchessCompactMove move ) const
+{
+	static constexpr BYTE leastValuable[6] = { PAWN , KNIGHT , BISHOP , ROOK , QUEEN , KING };
+	static constexpr uint64_t promotionRanks = lchessBitboard::RANK_1 | lchessBitboard::RANK_8;
+
+	if ( move.isCastle() ) return 0;
+
+	const int from = move.from();
+	const int to = move.to();
+	const uint64_t target = lchessBitboard::squareBit( to );
+	uint64_t occupied = this->getOccupied() ^ lchessBitboard::squareBit( from );
+
+	int gains[32];
+	if ( move.isEnPassant() )
+	{
+		gains[0] = PIECE_VALUES[PAWN];
+		// the captured pawn is not on the target square, a slider behind it is revealed
+		occupied ^= lchessBitboard::squareBit( to^8 );
+	}
+	else gains[0] = this->isEmpty( to ) ? 0 : PIECE_VALUES[this->board[to] & PIECE_TYPE_MASK];
+
+	// the value of the piece that stands on the square after the last capture
+	int victim = PIECE_VALUES[this->board[from] & PIECE_TYPE_MASK];
+	if ( move.isPromotion() )
+	{
+		gains[0] += PIECE_VALUES[move.promotionType()]-PIECE_VALUES[PAWN];
+		victim = PIECE_VALUES[move.promotionType()];
+	}
+
+	const uint64_t diagonal = this->pieceBitboards[BISHOP] | this->pieceBitboards[QUEEN];
+	const uint64_t straight = this->pieceBitboards[ROOK] | this->pieceBitboards[QUEEN];
+	uint64_t attackers = ( this->attackersTo( to , WHITE , occupied ) | this->attackersTo( to , BLACK , occupied ) ) & occupied;
+	int side = colorIndex( this->board[from] )^1;
+
+	int count = 0;
+	while ( true )
+	{
+		const uint64_t own = attackers & this->colorBitboards[side];
+		if ( !own ) break;
+
+		int type = 0;
+		while ( !( own & this->pieceBitboards[leastValuable[type]] ) ) ++type;
+		const BYTE piece = leastValuable[type];
+
+		// the king can only take if the square is not defended any more
+		if ( piece == KING && ( attackers & this->colorBitboards[side^1] ) ) break;
+
+		++count;
+		gains[count] = victim-gains[count-1];
+		victim = PIECE_VALUES[piece];
+		if ( piece == PAWN && ( target & promotionRanks ) )
 		{
-			return this->threatMap.isWhiteThreat(i);
+			gains[count] += PIECE_VALUES[QUEEN]-PIECE_VALUES[PAWN];
+			victim = PIECE_VALUES[QUEEN];
 		}
+
+		// taking the piece off the board reveals the sliders behind it
+		occupied ^= lchessBitboard::squareBit( lchessBitboard::bitScanForward( own & this->pieceBitboards[piece] ) );
+		if ( piece == PAWN || piece == BISHOP || piece == QUEEN ) attackers |= lchessBitboard::bishopAttacks( to , occupied ) & diagonal;
+		if ( piece == ROOK || piece == QUEEN ) attackers |= lchessBitboard::rookAttacks( to , occupied ) & straight;
+		attackers &= occupied;
+		side ^= 1;
 	}
-	std::cout << "lchessBoard > isBlackInCheck > no black king found, something is wrong" << std::endl;
-	return true;
+
+	while ( count > 0 )
+	{
+		gains[count-1] = -std::max( -gains[count-1] , gains[count] );
+		--count;
+	}
+	return gains[0];
 }
 
 
@@ -853,6 +657,69 @@ lchessGameState lchessBoard::getGameState() const
 
 
 
+BYTE lchessBoard::getCastlingRights() const
+{
+	BYTE rights = 0;
+	if ( !this->b_whiteKingMoved && !this->b_h1RookMoved ) rights |= 0x1;
+	if ( !this->b_whiteKingMoved && !this->b_a1RookMoved ) rights |= 0x2;
+	if ( !this->b_blackKingMoved && !this->b_h8RookMoved ) rights |= 0x4;
+	if ( !this->b_blackKingMoved && !this->b_a8RookMoved ) rights |= 0x8;
+	return rights;
+}
+
+
+
+uint64_t lchessBoard::computeHash() const
+{
+	uint64_t hash = this->stateHash();
+	uint64_t pieces = this->getOccupied();
+	while ( pieces )
+	{
+		const int index = lchessBitboard::popLsb( pieces );
+		hash ^= lchessZobrist::piece( this->board[index] , index );
+	}
+	return hash;
+}
+
+
+
+bool lchessBoard::isInsufficientMaterial() const
+{
+	// a pawn, rook or queen can always still mate
+	constexpr uint64_t mating = ( materialBit( WHITE_PAWN ) | materialBit( WHITE_ROOK ) | materialBit( WHITE_QUEEN ) | materialBit( BLACK_PAWN ) | materialBit( BLACK_ROOK ) | materialBit( BLACK_QUEEN ) )*0xF;
+	if ( this->materialKey & mating ) return false;
+
+	const int knights = this->getPieceCount( WHITE_KNIGHT )+this->getPieceCount( BLACK_KNIGHT );
+	const int bishops = this->getPieceCount( WHITE_BISHOP )+this->getPieceCount( BLACK_BISHOP );
+
+	// bare kings or a single minor piece
+	if ( knights+bishops <= 1 ) return true;
+
+	// bishops that all stand on squares of one color can never mate, whichever side they belong to
+	if ( knights == 0 )
+	{
+		const uint64_t bishopSquares = this->pieceBitboards[BISHOP];
+		return !( bishopSquares & lchessBitboard::DARK_SQUARES ) || !( bishopSquares & lchessBitboard::LIGHT_SQUARES );
+	}
+	return false;
+}
+
+
+
+bool lchessBoard::isRepetition( const int times ) const
+{
+	// the same side has to be to move, so only every second position is compared
+	const int last = std::min( std::min( this->halfmoveClock , this->historyCount ) , HASH_HISTORY_SIZE );
+	int found = 0;
+	for ( int i = 4 ; i <= last ; i += 2 )
+	{
+		if ( this->hashHistory[( this->historyCount-i ) & ( HASH_HISTORY_SIZE-1 )] == this->hash && ++found >= times ) return true;
+	}
+	return false;
+}
+
+
+
 std::string lchessBoard::toChessCoords( const int index )
 {
 	int file = (index%8);
@@ -909,7 +776,7 @@ void lchessBoard::print() const
 
 void lchessBoard::allocateMemory()
 {
-	possibleMoves.resize( 256 );
+	lchessBitboard::init();
 }
 
 
@@ -920,6 +787,348 @@ private functions
 
 
 
+BYTE lchessBoard::getCastlingFlags() const
+{
+	return BYTE( this->b_whiteKingMoved | ( this->b_blackKingMoved << 1 ) | ( this->b_a1RookMoved << 2 ) | ( this->b_h1RookMoved << 3 ) | ( this->b_a8RookMoved << 4 ) | ( this->b_h8RookMoved << 5 ) );
+}
+
+
+
+void lchessBoard::setCastlingFlags( const BYTE flags )
+{
+	this->b_whiteKingMoved = flags & 0x01;
+	this->b_blackKingMoved = flags & 0x02;
+	this->b_a1RookMoved = flags & 0x04;
+	this->b_h1RookMoved = flags & 0x08;
+	this->b_a8RookMoved = flags & 0x10;
+	this->b_h8RookMoved = flags & 0x20;
+}
+
+
+
+BYTE lchessBoard::packPawnMoved( const bool* pawnMoved )
+{
+	BYTE flags = 0;
+	for ( int i = 0 ; i < 8 ; ++i ) flags |= BYTE( pawnMoved[i] << i );
+	return flags;
+}
+
+
+
+void lchessBoard::unpackPawnMoved( bool* pawnMoved , const BYTE flags )
+{
+	for ( int i = 0 ; i < 8 ; ++i ) pawnMoved[i] = ( flags >> i ) & 1;
+}
+
+
+
+uint64_t lchessBoard::stateHash() const
+{
+	uint64_t hash = lchessZobrist::castling( this->getCastlingRights() );
+
+	// the pawn that can be captured en passant belongs to the side that is not to move
+	const bool* pawnMoved = ( this->sideToMove == WHITE ) ? this->b_blackPawnMoved : this->b_whitePawnMoved;
+	for ( int i = 0 ; i < 8 ; ++i )
+	{
+		if ( pawnMoved[i] ) hash ^= lchessZobrist::enPassant( i );
+	}
+
+	if ( this->sideToMove == BLACK ) hash ^= lchessZobrist::side();
+	return hash;
+}
+
+
+
+template< BYTE Color >
+void lchessBoard::generateLegalMoves( lchessMoveList& moves ) const
+{
+	typedef lchessColorTraits< Color > Us;
+
+	LCHESS_MEASURE( PHASE_LEGALITY );
+
+	const uint64_t own = this->getColorPieces( Color );
+	const uint64_t enemy = this->getColorPieces( Us::them );
+	const uint64_t occupied = own | enemy;
+	const int kingSquare = this->getKingSquare( Color );
+
+	// the pieces giving check and the pieces pinned against the king, everything below only generates legal moves
+	const uint64_t checkers = this->attackersTo( kingSquare , Us::them , occupied );
+	const uint64_t pinned = this->pinnedPieces< Color >( kingSquare );
+
+	// when in check a move has to capture the checking piece or block it, in double check only the king can move
+	uint64_t checkMask = ~uint64_t(0);
+	if ( checkers ) checkMask = lchessBitboard::between( kingSquare , lchessBitboard::bitScanForward( checkers ) ) | checkers;
+	if ( lchessBitboard::popCount( checkers ) > 1 ) checkMask = 0;
+
+	// all squares the enemy attacks are computed at once, the king itself is taken out of the occupancy so it cannot
+	// hide behind itself on a slider's ray
+	const uint64_t danger = lchessThreatMap::attacksOf( *this , Us::them , occupied ^ lchessBitboard::squareBit( kingSquare ) );
+
+	LCHESS_MEASURE_NEXT( PHASE_GENERATION );
+
+	// a pinned pawn may only move along the line through the king and the pinning piece, a pawn reaching the last
+	// rank is added once for every promotion piece
+	auto addPawnMove = [&]( const int from , const int to , const uint16_t flags )
+	{
+		if ( ( pinned & lchessBitboard::squareBit( from ) ) && !( lchessBitboard::line( kingSquare , from ) & lchessBitboard::squareBit( to ) ) ) return;
+		if ( Us::promotionRank & lchessBitboard::squareBit( to ) ) moves.addPromotions( from , to );
+		else moves.add( from , to , flags );
+	};
+
+	// pawns
+	const uint64_t pawns = this->getPieces( Us::pawn );
+	uint64_t singlePushes = Us::shift( pawns , Us::up ) & ~occupied;
+	uint64_t doublePushes = Us::shift( singlePushes & Us::doublePushRank , Us::up ) & ~occupied & checkMask;
+	uint64_t capturesLeft = Us::shift( pawns & ~lchessBitboard::FILE_A , Us::upLeft ) & enemy & checkMask;
+	uint64_t capturesRight = Us::shift( pawns & ~lchessBitboard::FILE_H , Us::upRight ) & enemy & checkMask;
+	singlePushes &= checkMask;
+	while ( singlePushes )
+	{
+		int to = lchessBitboard::popLsb( singlePushes );
+		addPawnMove( to-Us::up , to , lchessCompactMove::NORMAL );
+	}
+	while ( doublePushes )
+	{
+		int to = lchessBitboard::popLsb( doublePushes );
+		addPawnMove( to-2*Us::up , to , lchessCompactMove::DOUBLE_PUSH );
+	}
+	while ( capturesLeft )
+	{
+		int to = lchessBitboard::popLsb( capturesLeft );
+		addPawnMove( to-Us::upLeft , to , lchessCompactMove::NORMAL );
+	}
+	while ( capturesRight )
+	{
+		int to = lchessBitboard::popLsb( capturesRight );
+		addPawnMove( to-Us::upRight , to , lchessCompactMove::NORMAL );
+	}
+	// en passant, the capturing pawns are the ones an enemy pawn on the target square would attack
+	const bool* enemyPawnMoved = ( Color == WHITE ) ? this->b_blackPawnMoved : this->b_whitePawnMoved;
+	for ( int x = 0 ; x < 8 && checkMask ; ++x )
+	{
+		if ( !enemyPawnMoved[x] ) continue;
+		uint64_t attackers = lchessBitboard::pawnAttacks( Us::them , Us::enPassantTargets+x ) & pawns;
+		while ( attackers )
+		{
+			int from = lchessBitboard::popLsb( attackers );
+			if ( this->isLegalEnPassant< Color >( from , Us::enPassantTargets+x ) ) moves.add( from , Us::enPassantTargets+x , lchessCompactMove::EN_PASSANT );
+		}
+	}
+
+	// knights, a pinned knight can never move
+	uint64_t knights = this->getPieces( Color | KNIGHT ) & ~pinned;
+	while ( knights )
+	{
+		int from = lchessBitboard::popLsb( knights );
+		uint64_t targets = lchessBitboard::knightAttacks( from ) & ~own & checkMask;
+		while ( targets )
+		{
+			moves.add( from , lchessBitboard::popLsb( targets ) );
+		}
+	}
+
+	// bishops
+	uint64_t bishops = this->getPieces( Color | BISHOP );
+	while ( bishops )
+	{
+		int from = lchessBitboard::popLsb( bishops );
+		uint64_t targets = lchessBitboard::bishopAttacks( from , occupied ) & ~own & checkMask;
+		if ( pinned & lchessBitboard::squareBit( from ) ) targets &= lchessBitboard::line( kingSquare , from );
+		while ( targets )
+		{
+			moves.add( from , lchessBitboard::popLsb( targets ) );
+		}
+	}
+
+	// rooks
+	uint64_t rooks = this->getPieces( Color | ROOK );
+	while ( rooks )
+	{
+		int from = lchessBitboard::popLsb( rooks );
+		uint64_t targets = lchessBitboard::rookAttacks( from , occupied ) & ~own & checkMask;
+		if ( pinned & lchessBitboard::squareBit( from ) ) targets &= lchessBitboard::line( kingSquare , from );
+		while ( targets )
+		{
+			moves.add( from , lchessBitboard::popLsb( targets ) );
+		}
+	}
+
+	// queens
+	uint64_t queens = this->getPieces( Color | QUEEN );
+	while ( queens )
+	{
+		int from = lchessBitboard::popLsb( queens );
+		uint64_t targets = lchessBitboard::queenAttacks( from , occupied ) & ~own & checkMask;
+		if ( pinned & lchessBitboard::squareBit( from ) ) targets &= lchessBitboard::line( kingSquare , from );
+		while ( targets )
+		{
+			moves.add( from , lchessBitboard::popLsb( targets ) );
+		}
+	}
+
+	// king
+	uint64_t targets = lchessBitboard::kingAttacks( kingSquare ) & ~own & ~danger;
+	while ( targets )
+	{
+		moves.add( kingSquare , lchessBitboard::popLsb( targets ) );
+	}
+
+	// castles
+	const bool kingMoved = ( Color == WHITE ) ? this->b_whiteKingMoved : this->b_blackKingMoved;
+	if ( !checkers && !kingMoved && kingSquare == Us::kingStart )
+	{
+		// queen side castle
+		const bool queenRookMoved = ( Color == WHITE ) ? this->b_a1RookMoved : this->b_a8RookMoved;
+		if ( !queenRookMoved && this->getPiece( Us::kingStart-4 ) == Us::rook )
+		{
+			// are the squares empty and is none of the squares under attack
+			if ( !( occupied & Us::queenSideEmpty ) && !( danger & Us::queenSidePath ) )
+			{
+				moves.add( Us::kingStart , Us::kingStart-2 , lchessCompactMove::CASTLE );
+			}
+		}
+		// king side castle
+		const bool kingRookMoved = ( Color == WHITE ) ? this->b_h1RookMoved : this->b_h8RookMoved;
+		if ( !kingRookMoved && this->getPiece( Us::kingStart+3 ) == Us::rook )
+		{
+			// are the squares empty and is none of the squares under attack
+			if ( !( occupied & Us::kingSideEmpty ) && !( danger & Us::kingSidePath ) )
+			{
+				moves.add( Us::kingStart , Us::kingStart+2 , lchessCompactMove::CASTLE );
+			}
+		}
+	}
+}
+
+
+
+template< BYTE Color >
+bool lchessBoard::isInCheck() const
+{
+	return this->attackersTo( this->getKingSquare( Color ) , lchessColorTraits< Color >::them ) != 0;
+}
+
+
+
+// the pieces of the given color that are the only piece between their king and an enemy slider
+template< BYTE Color >
+uint64_t lchessBoard::pinnedPieces( const int kingSquare ) const
+{
+	const BYTE them = lchessColorTraits< Color >::them;
+	const uint64_t occupied = this->getOccupied();
+	uint64_t snipers = ( lchessBitboard::bishopRays( kingSquare ) & ( this->getPieces( them | BISHOP ) | this->getPieces( them | QUEEN ) ) )
+		| ( lchessBitboard::rookRays( kingSquare ) & ( this->getPieces( them | ROOK ) | this->getPieces( them | QUEEN ) ) );
+
+	uint64_t pinned = 0;
+	while ( snipers )
+	{
+		uint64_t blockers = lchessBitboard::between( kingSquare , lchessBitboard::popLsb( snipers ) ) & occupied;
+		// exactly one piece in between and it is our own
+		if ( blockers && !( blockers & ( blockers-1 ) ) ) pinned |= blockers & this->getColorPieces( Color );
+	}
+	return pinned;
+}
+
+
+
+// en passant removes two pieces from a rank at once which the pin masks do not cover, so these moves are played
+// on the bitboards and tested directly
+template< BYTE Color >
+bool lchessBoard::isLegalEnPassant( const int from , const int to ) const
+{
+	const int kingSquare = this->getKingSquare( Color );
+	const int capturedSquare = to-lchessColorTraits< Color >::up;
+
+	const uint64_t occupied = ( this->getOccupied() ^ lchessBitboard::squareBit( from ) ^ lchessBitboard::squareBit( capturedSquare ) ) | lchessBitboard::squareBit( to );
+
+	// the captured pawn is still in the bitboards, so it is taken out of the attackers
+	return !( this->attackersTo( kingSquare , lchessColorTraits< Color >::them , occupied ) & ~lchessBitboard::squareBit( capturedSquare ) );
+}
+
+
+
+void lchessBoard::setGameState( const lchessGameState state , const lchessEventReason reason , const BYTE color )
+{
+	if ( this->gameState == state ) return;
+	this->gameState = state;
+
+	lchessEvent event;
+	event.type = EVENT_GAME_STATE;
+	event.reason = reason;
+	event.state = state;
+	event.color = color;
+	lchessDiagnostics::publish( event );
+}
+
+
+
+void lchessBoard::reportError( const lchessEventReason reason , const BYTE color )
+{
+	lchessEvent event;
+	event.type = EVENT_ERROR;
+	event.reason = reason;
+	event.state = lchessGameState::ONGOING;
+	event.color = color;
+	lchessDiagnostics::publish( event );
+}
+
+
+
+// a side without a king has no bucket and is skipped, its row is refreshed when the king is put back, so the own king
+// is never added or removed as a feature of its own side
+void lchessBoard::putFeatures( const BYTE piece , const int index )
+{
+	for ( int perspective = 0 ; perspective < 2 ; ++perspective )
+	{
+		const int kingSquare = this->kingSquares[perspective];
+		if ( kingSquare == NO_SQUARE ) continue;
+		if ( ( piece & PIECE_TYPE_MASK ) == KING && colorIndex( piece ) == perspective ) this->network->refresh( this->accumulator , perspective , *this );
+		else this->network->addFeature( this->accumulator , perspective , lchessNetwork::featureIndex( perspective , piece , index , kingSquare ) );
+	}
+}
+
+
+
+void lchessBoard::removeFeatures( const BYTE piece , const int index )
+{
+	for ( int perspective = 0 ; perspective < 2 ; ++perspective )
+	{
+		const int kingSquare = this->kingSquares[perspective];
+		if ( kingSquare == NO_SQUARE ) continue;
+		this->network->removeFeature( this->accumulator , perspective , lchessNetwork::featureIndex( perspective , piece , index , kingSquare ) );
+	}
+}
+
+
+
+void lchessBoard::moveFeatures( const BYTE piece , const int from , const int to )
+{
+	for ( int perspective = 0 ; perspective < 2 ; ++perspective )
+	{
+		const int kingSquare = this->kingSquares[perspective];
+		if ( kingSquare == NO_SQUARE ) continue;
+
+		// a king that changes its bucket changes every feature of its side
+		if ( ( piece & PIECE_TYPE_MASK ) == KING && colorIndex( piece ) == perspective && lchessNetwork::kingBucket( perspective , from ) != lchessNetwork::kingBucket( perspective , to ) )
+		{
+			this->network->refresh( this->accumulator , perspective , *this );
+			continue;
+		}
+		this->network->moveFeature( this->accumulator , perspective , lchessNetwork::featureIndex( perspective , piece , from , kingSquare ) , lchessNetwork::featureIndex( perspective , piece , to , kingSquare ) );
+	}
+}
+
+
+
+void lchessBoard::refreshAccumulator()
+{
+	if ( !this->network ) return;
+	this->network->refresh( this->accumulator , 0 , *this );
+	this->network->refresh( this->accumulator , 1 , *this );
+}
+
+
+
 void lchessBoard::printPiece( const BYTE pieceType ) const
 {
 #ifndef LINUX
@@ -1010,3 +1219,26 @@ void lchessMove::print() const
 	}
 	std::cout << lchessBoard::toChessCoords(from) << " -> " << lchessBoard::toChessCoords(to) << std::endl;
 }
+
+
+
+/*
+lchessCompactMove
+*/
+
+
+
+std::string lchessCompactMove::toString() const
+{
+	static const char promotionChars[4] = { 'n' , 'b' , 'r' , 'q' };
+	std::string result = lchessBoard::toChessCoords( this->from() )+lchessBoard::toChessCoords( this->to() );
+	if ( this->isPromotion() ) result += promotionChars[this->flags() & 0x3];
+	return result;
+}
+
+
+
+void lchessCompactMove::print() const
+{
+	std::cout << this->toString() << std::endl;
+}
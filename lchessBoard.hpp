@@ -6,28 +6,84 @@ use at own risk
 #include "lchess_includes.hpp"
 
 #include "lchessThreatMap.hpp"
+#include "lchessBitboard.hpp"
+#include "lchessZobrist.hpp"
+#include "lchessEvaluation.hpp"
+#include "lchessNetwork.hpp"
+#include "lchessInstrumentation.hpp"
+#include "lchessDiagnostics.hpp"
 class lchessThreatMap;
 
 
 
-#define EMPTY 0x00
+/*
+a move packed into 16 bits, bits 0-5 are the from square, bits 6-11 the to square and bits 12-15 the flags
+the moved piece is not stored, it is the piece on the from square of the position the move belongs to
+*/
+class lchessCompactMove
+{
+public:
+	static constexpr uint16_t NORMAL = 0x0;
+	static constexpr uint16_t DOUBLE_PUSH = 0x1;
+	static constexpr uint16_t CASTLE = 0x2;
+	static constexpr uint16_t EN_PASSANT = 0x3;
+	// promotions have this bit set, the two low bits select knight, bishop, rook or queen
+	static constexpr uint16_t PROMOTION = 0x8;
+
+	lchessCompactMove() : data( 0 ) {}
+	lchessCompactMove( const int from , const int to , const uint16_t flags = NORMAL ) : data( uint16_t( from | ( to << 6 ) | ( flags << 12 ) ) ) {}
+
+	inline int from() const { return this->data & 0x3F; }
+	inline int to() const { return ( this->data >> 6 ) & 0x3F; }
+	inline uint16_t flags() const { return this->data >> 12; }
+
+	inline bool isDoublePush() const { return this->flags() == DOUBLE_PUSH; }
+	inline bool isCastle() const { return this->flags() == CASTLE; }
+	inline bool isEnPassant() const { return this->flags() == EN_PASSANT; }
+	inline bool isPromotion() const { return this->flags() & PROMOTION; }
+
+	// the piece type a pawn promotes to (KNIGHT, BISHOP, ROOK or QUEEN) or EMPTY if the move is no promotion
+	inline BYTE promotionType() const
+	{
+		static constexpr BYTE types[4] = { KNIGHT , BISHOP , ROOK , QUEEN };
+		return this->isPromotion() ? types[this->flags() & 0x3] : BYTE( EMPTY );
+	}
 
-#define WHITE 0x10
-#define BLACK 0x20
+	// the flags of a promotion to the given piece, the color of the piece is ignored
+	static inline uint16_t promotionFlags( const BYTE piece )
+	{
+		switch ( piece & PIECE_TYPE_MASK )
+		{
+		case KNIGHT: return PROMOTION | 0x0;
+		case BISHOP: return PROMOTION | 0x1;
+		case ROOK: return PROMOTION | 0x2;
+		default: return PROMOTION | 0x3;
+		}
+	}
 
-#define WHITE_PAWN 0x10
-#define WHITE_ROOK 0x11
-#define WHITE_KNIGHT 0x12
-#define WHITE_BISHOP 0x13
-#define WHITE_QUEEN 0x14
-#define WHITE_KING 0x15
+	// the null move, from and to are the same square so it never is a real move
+	inline bool isNull() const { return this->data == 0; }
 
-#define BLACK_PAWN 0x20
-#define BLACK_ROOK 0x21
-#define BLACK_KNIGHT 0x22
-#define BLACK_BISHOP 0x23
-#define BLACK_QUEEN 0x24
-#define BLACK_KING 0x25
+	// the raw 16 bits, for storing the move in tables
+	inline uint16_t raw() const { return this->data; }
+	static inline lchessCompactMove fromRaw( const uint16_t data )
+	{
+		lchessCompactMove move;
+		move.data = data;
+		return move;
+	}
+
+	inline bool operator==( const lchessCompactMove& move ) const { return this->data == move.data; }
+	inline bool operator!=( const lchessCompactMove& move ) const { return this->data != move.data; }
+
+	// the move in coordinate notation, e.g. e2e4 or e7e8n
+	std::string toString() const;
+	void print() const;
+private:
+	uint16_t data;
+};
+
+static_assert( sizeof( lchessCompactMove ) == 2 , "lchessCompactMove has to fit in 16 bits" );
 
 
 
@@ -38,13 +94,16 @@ public:
 	BYTE to;
 	BYTE piece;
 	BYTE enPassant;
+	// the piece a pawn promotes to, EMPTY promotes to a queen
+	BYTE promotion;
 
-	inline void update( const BYTE from , const BYTE to , const BYTE piece , const BYTE enPassant = false )
+	inline void update( const BYTE from , const BYTE to , const BYTE piece , const BYTE enPassant = false , const BYTE promotion = EMPTY )
 	{
 		this->from = from;
 		this->to = to;
 		this->piece = piece;
 		this->enPassant = enPassant;
+		this->promotion = promotion;
 	}
 
 	inline void update( const lchessMove& move )
@@ -53,6 +112,7 @@ public:
 		this->to = move.to;
 		this->piece = move.piece;
 		this->enPassant = move.enPassant;
+		this->promotion = move.promotion;
 	}
 
 	inline bool equals( const lchessMove& move ) const
@@ -61,6 +121,7 @@ public:
 		if ( this->to != move.to ) return false;
 		if ( this->piece != move.piece ) return false;
 		if ( this->enPassant != move.enPassant ) return false;
+		if ( this->promotion != move.promotion ) return false;
 		return true;
 	}
 
@@ -94,6 +155,32 @@ public:
 		return false;
 	}
 
+	// returns true if the move is a pawn move to the last rank
+	inline bool isPromotion() const
+	{
+		if ( this->piece == WHITE_PAWN && this->toY() == 7 ) return true;
+		if ( this->piece == BLACK_PAWN && this->toY() == 0 ) return true;
+		return false;
+	}
+
+	// the piece the moved piece turns into, only differs from piece for promotions
+	inline BYTE resultingPiece() const
+	{
+		if ( !this->isPromotion() ) return this->piece;
+		return BYTE( ( this->piece & PIECE_COLOR_MASK ) | ( ( this->promotion != EMPTY ) ? ( this->promotion & PIECE_TYPE_MASK ) : QUEEN ) );
+	}
+
+	// the 16 bit form of the move, lchessBoard::toMove turns it back with the piece of the position
+	inline lchessCompactMove pack() const
+	{
+		uint16_t flags = lchessCompactMove::NORMAL;
+		if ( this->enPassant ) flags = lchessCompactMove::EN_PASSANT;
+		else if ( this->isCastle() ) flags = lchessCompactMove::CASTLE;
+		else if ( this->isPromotion() ) flags = lchessCompactMove::promotionFlags( this->resultingPiece() );
+		else if ( ( this->piece & PIECE_TYPE_MASK ) == PAWN && ( this->to-this->from == 16 || this->from-this->to == 16 ) ) flags = lchessCompactMove::DOUBLE_PUSH;
+		return lchessCompactMove( this->from , this->to , flags );
+	}
+
 	void print() const;
 private:
 
@@ -101,8 +188,114 @@ private:
 
 
 
+// more than the maximum number of legal moves in any chess position
+#define MAX_LEGAL_MOVES 256
+
 /*
-a simple chess board representation with a single byte per piece
+a fixed size list of moves that lives on the stack of its owner, so no allocation happens during move generation and
+every thread can generate moves into its own list
+*/
+class lchessMoveList
+{
+public:
+	lchessMoveList() : count( 0 ) {}
+
+	inline void add( const int from , const int to , const uint16_t flags = lchessCompactMove::NORMAL )
+	{
+		this->moves[this->count++] = lchessCompactMove( from , to , flags );
+	}
+
+	// adds the four promotions of a pawn move
+	inline void addPromotions( const int from , const int to )
+	{
+		this->add( from , to , lchessCompactMove::PROMOTION | 0x3 );
+		this->add( from , to , lchessCompactMove::PROMOTION | 0x2 );
+		this->add( from , to , lchessCompactMove::PROMOTION | 0x1 );
+		this->add( from , to , lchessCompactMove::PROMOTION | 0x0 );
+	}
+
+	inline void clear() { this->count = 0; }
+	inline int size() const { return this->count; }
+	inline bool empty() const { return this->count == 0; }
+
+	inline lchessCompactMove& operator[]( const int index ) { return this->moves[index]; }
+	inline const lchessCompactMove& operator[]( const int index ) const { return this->moves[index]; }
+
+	inline lchessCompactMove* begin() { return this->moves; }
+	inline lchessCompactMove* end() { return this->moves+this->count; }
+	inline const lchessCompactMove* begin() const { return this->moves; }
+	inline const lchessCompactMove* end() const { return this->moves+this->count; }
+
+private:
+	lchessCompactMove moves[MAX_LEGAL_MOVES];
+	int count;
+};
+
+
+
+// the number of moves that can be taken back with unmakeMove, enough for a search on top of a long game
+#define MAX_UNDO_MOVES 1024
+
+/*
+everything makeMove overwrites that cannot be derived from the move itself
+*/
+struct lchessUndo
+{
+	lchessCompactMove move;
+	BYTE piece;
+	BYTE captured;
+	BYTE castlingFlags;
+	BYTE whitePawnMoved;
+	BYTE blackPawnMoved;
+	BYTE gameState;
+	uint16_t halfmoveClock;
+	uint64_t hash;
+};
+
+
+
+/*
+compile time constants for one side, the color templated move generation is specialized with these
+*/
+template< BYTE Color >
+struct lchessColorTraits
+{
+	static constexpr BYTE them = ( Color == WHITE ) ? BLACK : WHITE;
+	static constexpr BYTE pawn = Color | PAWN;
+	static constexpr BYTE rook = Color | ROOK;
+	static constexpr BYTE king = Color | KING;
+
+	// pawn move directions as square offsets
+	static constexpr int up = ( Color == WHITE ) ? 8 : -8;
+	static constexpr int upLeft = ( Color == WHITE ) ? 7 : -9;
+	static constexpr int upRight = ( Color == WHITE ) ? 9 : -7;
+
+	// the rank a single push from the start rank ends on, the promotion rank and the first en passant target square
+	static constexpr uint64_t doublePushRank = ( Color == WHITE ) ? lchessBitboard::RANK_3 : lchessBitboard::RANK_6;
+	static constexpr uint64_t promotionRank = ( Color == WHITE ) ? lchessBitboard::RANK_8 : lchessBitboard::RANK_1;
+	static constexpr int enPassantTargets = ( Color == WHITE ) ? 40 : 16;
+
+	// castling, the squares between king and rook that have to be empty
+	static constexpr int kingStart = ( Color == WHITE ) ? 4 : 60;
+	static constexpr uint64_t queenSideEmpty = uint64_t(0x0E) << ( kingStart-4 );
+	static constexpr uint64_t kingSideEmpty = uint64_t(0x60) << ( kingStart-4 );
+	// the squares the king passes over, they must not be attacked
+	static constexpr uint64_t queenSidePath = uint64_t(0x0C) << ( kingStart-4 );
+	static constexpr uint64_t kingSidePath = uint64_t(0x60) << ( kingStart-4 );
+
+	static inline uint64_t shift( const uint64_t bitboard , const int offset )
+	{
+		return ( offset > 0 ) ? bitboard << offset : bitboard >> -offset;
+	}
+};
+
+
+
+/*
+a chess board kept as bitboards per piece type and color with a mailbox of one byte per square next to them, legal
+moves are generated from the bitboards with magic sliding attacks, and every change to the pieces also updates the
+zobrist hash, the material key, the piece-square evaluation and the network accumulator if a network is set, so none
+of them has to be recomputed after a move
 */
 class lchessBoard
 {
@@ -111,16 +304,69 @@ public:
 	virtual ~lchessBoard();
 
 	void init();
+	// sets up the position of a fen string, returns false if the string could not be read
+	bool loadFen( const std::string& fen );
 
-	void getLegalMoves( std::vector< lchessMove >& moves , int& numberOfMoves , const BYTE color );
+	// fills the list with all legal moves of the given color and updates the game state
+	void getLegalMoves( lchessMoveList& moves , const BYTE color );
+	// fills the list with all legal moves of the side to move, the game state is not touched
+	void generateMoves( lchessMoveList& moves ) const;
 
-	int evaluatePosition() const;
+	// the largest score evaluatePosition returns, one below the mate scores of lchessSearch
+	static constexpr int MAX_EVALUATION = 30871;
 
-	void move( const lchessMove& move );
+	// the score in centipawns from the white point of view, the tapered piece-square score or the score of the network
+	// if one is set, both are kept up to date by every change to the board so this does not look at the pieces
+	inline int evaluatePosition() const
+	{
+		if ( !this->network ) return lchessEvaluation::taper( this->middleGameScore , this->endGameScore , this->gamePhase );
+		// the output of a network is only bounded by its weights
+		const int score = std::min( std::max( this->network->evaluate( this->accumulator , this->sideToMove ) , -MAX_EVALUATION ) , MAX_EVALUATION );
+		return ( this->sideToMove == WHITE ) ? score : -score;
+	}
+	// the same score computed from scratch
+	int computeEvaluation() const;
 
+	// evaluates with a loaded network instead of the piece-square tables, nullptr switches back, the network has to
+	// outlive the board and every copy of it
+	void setNetwork( const lchessNetwork* network );
+	inline const lchessNetwork* getNetwork() const { return this->network; }
+
+	void move( const lchessMove& move );
+	inline void move( const lchessCompactMove move ) { this->move( this->toMove( move ) ); }
+
+	// plays a move like move() and remembers what it changed, so it can be taken back with unmakeMove without
+	// copying the board, returns false, publishes an error event and does not play the move if MAX_UNDO_MOVES moves
+	// are already remembered
+	bool makeMove( const lchessMove& move );
+	inline bool makeMove( const lchessCompactMove move ) { return this->makeMove( this->toMove( move ) ); }
+	// takes back the last move played with makeMove
+	void unmakeMove();
+	// forgets the moves played with makeMove, e.g. for a copy that searches on its own, the position and the history
+	// of the repetition detection stay
+	inline void clearUndo() { this->undoCount = 0; }
+
+	// looks for attackers from the king square, the board keeps no threat map
 	bool isWhiteInCheck() const;
 	bool isBlackInCheck() const;
 
+	// all pieces of the given color that attack the square, found by looking outward from the square
+	uint64_t attackersTo( const int index , const BYTE color ) const;
+	// the same with a custom occupancy for the sliders, e.g. to look through pieces that are about to move
+	uint64_t attackersTo( const int index , const BYTE color , const uint64_t occupancy ) const;
+
+	// the piece values of the static exchange evaluation, indexed by piece type
+	static constexpr int PIECE_VALUES[6] = { 100 , 500 , 320 , 330 , 900 , 20000 };
+	// the material the side to move wins with the move when both sides keep capturing on its target square with their
+	// least valuable piece and may stop whenever that is better for them, pins are not looked at, castling scores 0
+	int staticExchange( const lchessCompactMove move ) const;
+
+	// the full move for a compact move of this position, the moved piece is taken from the board
+	lchessMove toMove( const lchessCompactMove move ) const;
+
+	// the square of the king of the given color or NO_SQUARE if there is none
+	inline int getKingSquare( const BYTE color ) const { return this->kingSquares[colorIndex(color)]; }
+
 	int toX( const int index ) const;
 	int toY( const int index ) const;
 
@@ -133,21 +379,76 @@ public:
 	BYTE getPiece( const int x , const int y ) const;
 	BYTE getColor( const int x , const int y ) const;
 	lchessGameState getGameState() const;
+	inline BYTE getSideToMove() const { return this->sideToMove; }
+	// the castle rights left as four bits, white king side, white queen side, black king side and black queen side
+	BYTE getCastlingRights() const;
+
+	// the zobrist hash of the position, kept up to date by every change to the board
+	inline uint64_t getHash() const { return this->hash; }
+	// the same hash computed from scratch
+	uint64_t computeHash() const;
+
+	// the number of moves since the last capture or pawn move
+	inline int getHalfmoveClock() const { return this->halfmoveClock; }
+	// true if the position occurred at least the given number of times before, only the positions since the last
+	// capture or pawn move are looked at because no earlier position can come back
+	bool isRepetition( const int times = 1 ) const;
+
+	// the number of pieces of every type and color, one nibble each, white pawn in the lowest nibble and black king
+	// in the highest, positions with the same material have the same key
+	inline uint64_t getMaterialKey() const { return this->materialKey; }
+	// the position of the nibble of the given piece in the material key
+	static constexpr int materialShift( const BYTE piece ) { return 4*( colorIndex(piece)*6+( piece & PIECE_TYPE_MASK ) ); }
+	static constexpr uint64_t materialBit( const BYTE piece ) { return uint64_t(1) << materialShift( piece ); }
+	// the number of pieces of the given piece type and color read from the material key
+	inline int getPieceCount( const BYTE piece ) const { return int( ( this->materialKey >> materialShift( piece ) ) & 0xF ); }
+	// true if neither side can mate with any series of legal moves, king against king, king and a minor piece
+	// against king, or only bishops that all stand on squares of the same color
+	bool isInsufficientMaterial() const;
+
+	// bitboard of all pieces of the given piece type and color, e.g. getPieces( WHITE_KNIGHT )
+	inline uint64_t getPieces( const BYTE piece ) const { return this->pieceBitboards[piece & PIECE_TYPE_MASK] & this->colorBitboards[colorIndex(piece)]; }
+	// bitboard of all pieces of the given color
+	inline uint64_t getColorPieces( const BYTE color ) const { return this->colorBitboards[colorIndex(color)]; }
+	inline uint64_t getOccupied() const { return this->colorBitboards[0] | this->colorBitboards[1]; }
 
 	static std::string toChessCoords( const int index );
 	static std::string toChessCoords( const int x , const int y );
 	void print() const;
 
+	// has to be called once before any board is used, it also builds the attack tables
 	static void allocateMemory();
 
 private:
-	// the position
+	// the position, the mailbox and the bitboards always describe the same position and must only be changed
+	// through putPiece, removePiece and movePiece
     BYTE board[64];
+	uint64_t pieceBitboards[6];
+	uint64_t colorBitboards[2];
+	BYTE kingSquares[2];
+
+	// the zobrist hash of the position
+	uint64_t hash;
+	// the piece counts, see getMaterialKey
+	uint64_t materialKey;
+	// the sums of the piece-square values and the game phase, see lchessEvaluation
+	int middleGameScore;
+	int endGameScore;
+	int gamePhase;
+
+	// the network evaluation, the accumulator is only kept up to date while a network is set
+	const lchessNetwork* network;
+	lchessAccumulator accumulator;
+
+	// the hashes of the positions before the last moves, a ring indexed by the number of moves played, it is large
+	// enough to hold every position the fifty move rule allows to repeat
+	static constexpr int HASH_HISTORY_SIZE = 128;
+	uint64_t hashHistory[HASH_HISTORY_SIZE];
+	int historyCount;
+	int halfmoveClock;
 
 	lchessGameState gameState;
-
-	// the threat map of the current position
-	lchessThreatMap threatMap;
+	BYTE sideToMove;
 
 	// have the castle pieces moved
 	bool b_whiteKingMoved;
@@ -161,9 +462,86 @@ private:
 	bool b_whitePawnMoved[8];
 	bool b_blackPawnMoved[8];
 
+	// the moves played with makeMove
+	lchessUndo undoStack[MAX_UNDO_MOVES];
+	int undoCount;
+
+	// the castle flags and en passant flags packed into one bit each
+	BYTE getCastlingFlags() const;
+	void setCastlingFlags( const BYTE flags );
+	static BYTE packPawnMoved( const bool* pawnMoved );
+	static void unpackPawnMoved( bool* pawnMoved , const BYTE flags );
+
+	// the part of the hash that does not belong to the pieces, castle rights, en passant files and side to move
+	uint64_t stateHash() const;
+
 	void printPiece( const BYTE pieceType ) const;
 
-	// a list to temporarily store all possible moves in a position before removing all illegal moves
-	static std::vector< lchessMove > possibleMoves;
-	static uint numberOfPossibleMoves;
+	// changes the game state and publishes the change as a diagnostic event
+	void setGameState( const lchessGameState state , const lchessEventReason reason , const BYTE color );
+	// publishes an error event, the color is the missing king for REASON_NO_KING and the side that tried to move for
+	// REASON_UNDO_STACK_FULL
+	static void reportError( const lchessEventReason reason , const BYTE color );
+
+	// the move generation is specialized for each color, getLegalMoves picks the specialization once
+	template< BYTE Color > void generateLegalMoves( lchessMoveList& moves ) const;
+	template< BYTE Color > bool isInCheck() const;
+	template< BYTE Color > uint64_t pinnedPieces( const int kingSquare ) const;
+	template< BYTE Color > bool isLegalEnPassant( const int from , const int to ) const;
+
+	// keep the accumulator up to date, called by putPiece, removePiece and movePiece after the board has changed
+	void putFeatures( const BYTE piece , const int index );
+	void removeFeatures( const BYTE piece , const int index );
+	void moveFeatures( const BYTE piece , const int from , const int to );
+	void refreshAccumulator();
+
+	// 0 for white and 1 for black, works for colors and pieces
+	static constexpr int colorIndex( const BYTE piece ) { return ( piece >> 5 ) & 1; }
+
+	inline void putPiece( const int index , const BYTE piece )
+	{
+		const uint64_t bit = lchessBitboard::squareBit( index );
+		this->board[index] = piece;
+		this->pieceBitboards[piece & PIECE_TYPE_MASK] |= bit;
+		this->colorBitboards[colorIndex(piece)] |= bit;
+		if ( ( piece & PIECE_TYPE_MASK ) == KING ) this->kingSquares[colorIndex(piece)] = index;
+		this->hash ^= lchessZobrist::piece( piece , index );
+		this->materialKey += materialBit( piece );
+		this->middleGameScore += lchessEvaluation::middleGame( piece , index );
+		this->endGameScore += lchessEvaluation::endGame( piece , index );
+		this->gamePhase += lchessEvaluation::phase( piece );
+		if ( this->network ) this->putFeatures( piece , index );
+	}
+
+	inline void removePiece( const int index )
+	{
+		const uint64_t bit = lchessBitboard::squareBit( index );
+		const BYTE piece = this->board[index];
+		this->board[index] = EMPTY;
+		this->pieceBitboards[piece & PIECE_TYPE_MASK] &= ~bit;
+		this->colorBitboards[colorIndex(piece)] &= ~bit;
+		if ( ( piece & PIECE_TYPE_MASK ) == KING ) this->kingSquares[colorIndex(piece)] = NO_SQUARE;
+		this->hash ^= lchessZobrist::piece( piece , index );
+		this->materialKey -= materialBit( piece );
+		this->middleGameScore -= lchessEvaluation::middleGame( piece , index );
+		this->endGameScore -= lchessEvaluation::endGame( piece , index );
+		this->gamePhase -= lchessEvaluation::phase( piece );
+		if ( this->network ) this->removeFeatures( piece , index );
+	}
+
+	// moves a piece to an empty square
+	inline void movePiece( const int from , const int to )
+	{
+		const uint64_t bits = lchessBitboard::squareBit( from ) | lchessBitboard::squareBit( to );
+		const BYTE piece = this->board[from];
+		this->board[from] = EMPTY;
+		this->board[to] = piece;
+		this->pieceBitboards[piece & PIECE_TYPE_MASK] ^= bits;
+		this->colorBitboards[colorIndex(piece)] ^= bits;
+		if ( ( piece & PIECE_TYPE_MASK ) == KING ) this->kingSquares[colorIndex(piece)] = to;
+		this->hash ^= lchessZobrist::piece( piece , from ) ^ lchessZobrist::piece( piece , to );
+		this->middleGameScore += lchessEvaluation::middleGame( piece , to )-lchessEvaluation::middleGame( piece , from );
+		this->endGameScore += lchessEvaluation::endGame( piece , to )-lchessEvaluation::endGame( piece , from );
+		if ( this->network ) this->moveFeatures( piece , from , to );
+	}
 };
\ No newline at end of file
@@ -0,0 +1,173 @@
+/*
+use at own risk
+*/
+#include "lchessDiagnostics.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+
+// a bounded queue for many producers and one consumer, every cell has a sequence number that tells whether it is
+// free for the producer that claimed its position or filled for the consumer
+struct lchessEventCell
+{
+	std::atomic<uint64_t> sequence;
+	lchessEvent event;
+};
+
+static lchessEventCell cells[lchessDiagnostics::CAPACITY];
+static std::atomic<uint64_t> tail( 0 );
+static uint64_t head = 0;
+
+static std::atomic<bool> attached( false );
+static std::atomic<bool> running( false );
+static std::atomic<uint64_t> dropped( 0 );
+static std::function<void( const lchessEvent& )> consumer;
+static std::thread drainThread;
+
+// stops the drain thread at exit if the consumer was never detached
+static struct lchessDiagnosticsShutdown
+{
+	~lchessDiagnosticsShutdown() { lchessDiagnostics::detach(); }
+} diagnosticsShutdown;
+
+
+
+static bool initCells()
+{
+	for ( uint64_t i = 0 ; i < lchessDiagnostics::CAPACITY ; ++i ) cells[i].sequence.store( i , std::memory_order_relaxed );
+	return true;
+}
+
+static const bool cellsInitialized = initCells();
+
+
+
+// hands every filled cell to the consumer, only called by the thread that owns the consumer side
+static bool drain()
+{
+	bool delivered = false;
+	while ( true )
+	{
+		lchessEventCell& cell = cells[head & ( lchessDiagnostics::CAPACITY-1 )];
+		if ( cell.sequence.load( std::memory_order_acquire ) != head+1 ) break;
+
+		const lchessEvent event = cell.event;
+		cell.sequence.store( head+lchessDiagnostics::CAPACITY , std::memory_order_release );
+		++head;
+
+		consumer( event );
+		delivered = true;
+	}
+	return delivered;
+}
+
+
+
+bool lchessDiagnostics::publish( const lchessEvent& event )
+{
+	if ( !attached.load( std::memory_order_relaxed ) ) return false;
+
+	uint64_t position = tail.load( std::memory_order_relaxed );
+	lchessEventCell* cell;
+	while ( true )
+	{
+		cell = &cells[position & ( CAPACITY-1 )];
+		const int64_t difference = int64_t( cell->sequence.load( std::memory_order_acquire ) )-int64_t( position );
+		if ( difference == 0 )
+		{
+			// the cell is free, claim the position
+			if ( tail.compare_exchange_weak( position , position+1 , std::memory_order_relaxed ) ) break;
+		}
+		else if ( difference < 0 )
+		{
+			// the consumer has not caught up, the buffer is full
+			dropped.fetch_add( 1 , std::memory_order_relaxed );
+			return false;
+		}
+		else
+		{
+			position = tail.load( std::memory_order_relaxed );
+		}
+	}
+
+	cell->event = event;
+	cell->sequence.store( position+1 , std::memory_order_release );
+	return true;
+}
+
+
+
+void lchessDiagnostics::attach( const std::function<void( const lchessEvent& )>& newConsumer )
+{
+	detach();
+
+	consumer = newConsumer;
+	running.store( true , std::memory_order_relaxed );
+	attached.store( true , std::memory_order_release );
+	drainThread = std::thread( []()
+	{
+		while ( running.load( std::memory_order_acquire ) )
+		{
+			if ( !drain() ) std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+		}
+		drain();
+	} );
+}
+
+
+
+void lchessDiagnostics::attachConsole()
+{
+	attach( []( const lchessEvent& event )
+	{
+		std::cout << toString( event ) << std::endl;
+	} );
+}
+
+
+
+void lchessDiagnostics::detach()
+{
+	if ( !drainThread.joinable() ) return;
+
+	attached.store( false , std::memory_order_relaxed );
+	running.store( false , std::memory_order_release );
+	drainThread.join();
+	consumer = nullptr;
+}
+
+
+
+bool lchessDiagnostics::isAttached()
+{
+	return attached.load( std::memory_order_relaxed );
+}
+
+
+
+uint64_t lchessDiagnostics::getDropped()
+{
+	return dropped.load( std::memory_order_relaxed );
+}
+
+
+
+std::string lchessDiagnostics::toString( const lchessEvent& event )
+{
+	const std::string color = ( event.color == WHITE ) ? "WHITE" : "BLACK";
+	switch ( event.reason )
+	{
+	case REASON_CHECKMATE: return color+" IS CHECKMATE";
+	case REASON_STALEMATE: return "DRAW";
+	case REASON_KING_VS_KING: return "DRAW (king vs king)";
+	case REASON_NO_KING: return "lchessBoard > no "+std::string( event.color == WHITE ? "white" : "black" )+" king found, something is wrong";
+	case REASON_FIFTY_MOVES: return "DRAW (fifty move rule)";
+	case REASON_REPETITION: return "DRAW (threefold repetition)";
+	case REASON_INSUFFICIENT_MATERIAL: return "DRAW (insufficient material)";
+	case REASON_UNDO_STACK_FULL: return "lchessBoard > makeMove > the undo stack is full, the "+std::string( event.color == WHITE ? "white" : "black" )+" move is not played";
+	}
+	return "";
+}
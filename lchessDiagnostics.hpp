@@ -0,0 +1,71 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+#include <functional>
+
+
+
+enum lchessEventType
+{
+	EVENT_GAME_STATE,	// the game state of a board changed
+	EVENT_ERROR			// a board is in a position it cannot handle
+};
+
+enum lchessEventReason
+{
+	REASON_CHECKMATE,
+	REASON_STALEMATE,
+	REASON_KING_VS_KING,
+	REASON_NO_KING,
+	REASON_FIFTY_MOVES,
+	REASON_REPETITION,
+	REASON_INSUFFICIENT_MATERIAL,
+	REASON_UNDO_STACK_FULL
+};
+
+/*
+a diagnostic event, small and without pointers so it can be copied through the ring buffer
+*/
+struct lchessEvent
+{
+	lchessEventType type;
+	lchessEventReason reason;
+	// the new game state for EVENT_GAME_STATE
+	lchessGameState state;
+	// the color the event is about, the side to move for game states and the missing king for REASON_NO_KING
+	BYTE color;
+};
+
+
+
+/*
+takes diagnostic events off the hot path, boards publish events into a lock-free ring buffer and a background thread
+hands them to the attached consumer, without a consumer events are dropped right away and when the buffer is full
+they are dropped and counted
+*/
+class lchessDiagnostics
+{
+public:
+	// the number of events the ring buffer holds, a power of two
+	static constexpr uint64_t CAPACITY = 1024;
+
+	// never blocks and can be called from any thread, returns false if the event was dropped
+	static bool publish( const lchessEvent& event );
+
+	// starts a background thread that calls the consumer for every published event, replaces an attached consumer
+	static void attach( const std::function<void( const lchessEvent& )>& consumer );
+	// a consumer that prints the events as text
+	static void attachConsole();
+	// delivers the events that are still in the buffer and stops the background thread
+	static void detach();
+
+	static bool isAttached();
+	// the events that did not fit into the buffer
+	static uint64_t getDropped();
+
+	static std::string toString( const lchessEvent& event );
+};
@@ -0,0 +1,58 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+
+
+/*
+piece-square values for the middle game and the end game, the value of a piece is its material plus a bonus for the
+square it stands on, white values are positive and black values negative so a position is the plain sum of its pieces
+
+the game phase counts the pieces that are traded off on the way to the end game, the evaluation blends the middle
+game and end game sums by it
+*/
+class lchessEvaluation
+{
+public:
+	// the phase with all minor and major pieces on the board
+	static constexpr int PHASE_TOTAL = 24;
+
+	static inline int middleGame( const BYTE piece , const int index )
+	{
+		return tables.middleGame[( piece >> 5 ) & 1][piece & PIECE_TYPE_MASK][index];
+	}
+
+	static inline int endGame( const BYTE piece , const int index )
+	{
+		return tables.endGame[( piece >> 5 ) & 1][piece & PIECE_TYPE_MASK][index];
+	}
+
+	// what the piece adds to the game phase, pawns and kings add nothing
+	static inline int phase( const BYTE piece )
+	{
+		return tables.phase[piece & PIECE_TYPE_MASK];
+	}
+
+	// the blended score in centipawns from the white point of view, more than the full phase counts as full
+	static inline int taper( const int middleGame , const int endGame , const int phase )
+	{
+		const int weight = ( phase < PHASE_TOTAL ) ? phase : PHASE_TOTAL;
+		return ( middleGame*weight+endGame*( PHASE_TOTAL-weight ) )/PHASE_TOTAL;
+	}
+
+private:
+	// all values are computed by the compiler from the tables in the source file
+	struct Tables
+	{
+		int middleGame[2][6][64];
+		int endGame[2][6][64];
+		int phase[6];
+	};
+
+	static const Tables tables;
+
+	static constexpr Tables buildTables();
+};
@@ -0,0 +1,134 @@
+/*
+use at own risk
+*/
+#include "lchessInstrumentation.hpp"
+
+#include <iomanip>
+
+#ifdef LCHESS_INSTRUMENTATION
+#include <mutex>
+
+
+
+static const char* phaseNames[PHASE_COUNT] = { "legality" , "generation" , "game state" };
+
+// the blocks of all running threads and the sums of the threads that have finished
+static std::mutex registryMutex;
+static std::vector<lchessInstrumentation::Block*> registry;
+static uint64_t retiredCalls[PHASE_COUNT];
+static uint64_t retiredNanoseconds[PHASE_COUNT];
+static uint64_t retiredHistogram[PHASE_COUNT][lchessInstrumentation::HISTOGRAM_BUCKETS];
+
+thread_local lchessInstrumentation::Block lchessInstrumentation::threadBlock;
+
+
+
+lchessInstrumentation::Block::Block()
+{
+	for ( int p = 0 ; p < PHASE_COUNT ; ++p )
+	{
+		this->calls[p].store( 0 , std::memory_order_relaxed );
+		this->nanoseconds[p].store( 0 , std::memory_order_relaxed );
+		for ( int b = 0 ; b < HISTOGRAM_BUCKETS ; ++b ) this->histogram[p][b].store( 0 , std::memory_order_relaxed );
+	}
+
+	std::lock_guard<std::mutex> lock( registryMutex );
+	registry.push_back( this );
+}
+
+
+
+lchessInstrumentation::Block::~Block()
+{
+	std::lock_guard<std::mutex> lock( registryMutex );
+	for ( int p = 0 ; p < PHASE_COUNT ; ++p )
+	{
+		retiredCalls[p] += this->calls[p].load( std::memory_order_relaxed );
+		retiredNanoseconds[p] += this->nanoseconds[p].load( std::memory_order_relaxed );
+		for ( int b = 0 ; b < HISTOGRAM_BUCKETS ; ++b ) retiredHistogram[p][b] += this->histogram[p][b].load( std::memory_order_relaxed );
+	}
+	for ( size_t i = 0 ; i < registry.size() ; ++i )
+	{
+		if ( registry[i] != this ) continue;
+		registry[i] = registry.back();
+		registry.pop_back();
+		break;
+	}
+}
+
+
+
+void lchessInstrumentation::dump( std::ostream& stream )
+{
+	std::lock_guard<std::mutex> lock( registryMutex );
+
+	stream << std::left << std::setw( 12 ) << "phase" << std::right << std::setw( 14 ) << "calls" << std::setw( 12 ) << "mean ns" << std::setw( 10 ) << "p50 <" << std::setw( 10 ) << "p90 <" << std::setw( 10 ) << "p99 <" << std::endl;
+	for ( int p = 0 ; p < PHASE_COUNT ; ++p )
+	{
+		uint64_t calls = retiredCalls[p];
+		uint64_t nanoseconds = retiredNanoseconds[p];
+		uint64_t histogram[HISTOGRAM_BUCKETS];
+		for ( int b = 0 ; b < HISTOGRAM_BUCKETS ; ++b ) histogram[b] = retiredHistogram[p][b];
+		for ( const Block* block : registry )
+		{
+			calls += block->calls[p].load( std::memory_order_relaxed );
+			nanoseconds += block->nanoseconds[p].load( std::memory_order_relaxed );
+			for ( int b = 0 ; b < HISTOGRAM_BUCKETS ; ++b ) histogram[b] += block->histogram[p][b].load( std::memory_order_relaxed );
+		}
+
+		// the percentiles are the upper bounds of the buckets they fall into
+		uint64_t percentiles[3] = {};
+		const double fractions[3] = { 0.5 , 0.9 , 0.99 };
+		for ( int i = 0 ; i < 3 ; ++i )
+		{
+			uint64_t seen = 0;
+			for ( int b = 0 ; b < HISTOGRAM_BUCKETS ; ++b )
+			{
+				seen += histogram[b];
+				if ( seen > 0 && seen >= fractions[i]*calls )
+				{
+					percentiles[i] = uint64_t(1) << ( b+1 );
+					break;
+				}
+			}
+		}
+
+		stream << std::left << std::setw( 12 ) << phaseNames[p] << std::right << std::setw( 14 ) << calls << std::setw( 12 ) << ( calls ? nanoseconds/calls : 0 )
+			<< std::setw( 10 ) << percentiles[0] << std::setw( 10 ) << percentiles[1] << std::setw( 10 ) << percentiles[2] << std::endl;
+	}
+}
+
+
+
+void lchessInstrumentation::reset()
+{
+	std::lock_guard<std::mutex> lock( registryMutex );
+	for ( int p = 0 ; p < PHASE_COUNT ; ++p )
+	{
+		retiredCalls[p] = 0;
+		retiredNanoseconds[p] = 0;
+		for ( int b = 0 ; b < HISTOGRAM_BUCKETS ; ++b ) retiredHistogram[p][b] = 0;
+		for ( Block* block : registry )
+		{
+			block->calls[p].store( 0 , std::memory_order_relaxed );
+			block->nanoseconds[p].store( 0 , std::memory_order_relaxed );
+			for ( int b = 0 ; b < HISTOGRAM_BUCKETS ; ++b ) block->histogram[p][b].store( 0 , std::memory_order_relaxed );
+		}
+	}
+}
+#else
+
+
+
+void lchessInstrumentation::dump( std::ostream& stream )
+{
+	stream << "instrumentation is compiled out, build with -DLCHESS_INSTRUMENTATION to enable it" << std::endl;
+}
+
+
+
+void lchessInstrumentation::reset()
+{
+
+}
+#endif
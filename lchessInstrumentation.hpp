@@ -0,0 +1,106 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+// the instrumentation is only compiled in when LCHESS_INSTRUMENTATION is defined, e.g. with -DLCHESS_INSTRUMENTATION,
+// release builds leave it undefined and every measurement expands to nothing
+#ifdef LCHESS_INSTRUMENTATION
+#include <atomic>
+#include <chrono>
+#endif
+
+
+
+// the measured parts of the move generation
+enum lchessPhase
+{
+	PHASE_LEGALITY,		// checkers, pinned pieces and the squares the king cannot move to
+	PHASE_GENERATION,	// the moves of all pieces with the legality masks applied
+	PHASE_GAME_STATE,	// checkmate, stalemate and draw detection
+	PHASE_COUNT
+};
+
+
+
+/*
+per thread counters and latency histograms for every phase, a thread only writes its own block so measuring needs no
+locks, dump adds up the blocks of all threads that are running or have finished
+*/
+class lchessInstrumentation
+{
+public:
+	// the histograms have a bucket per power of two nanoseconds
+	static constexpr int HISTOGRAM_BUCKETS = 32;
+
+	// prints calls, mean time and percentiles of every phase, or a note if the instrumentation is compiled out
+	static void dump( std::ostream& stream );
+	// sets all counters of all threads to 0
+	static void reset();
+
+#ifdef LCHESS_INSTRUMENTATION
+	struct Block
+	{
+		std::atomic<uint64_t> calls[PHASE_COUNT];
+		std::atomic<uint64_t> nanoseconds[PHASE_COUNT];
+		std::atomic<uint64_t> histogram[PHASE_COUNT][HISTOGRAM_BUCKETS];
+
+		Block();
+		~Block();
+	};
+
+	static inline void record( const lchessPhase phase , const uint64_t nanoseconds )
+	{
+		Block& block = threadBlock;
+		// only this thread writes the block, so a load and a store are enough
+		block.calls[phase].store( block.calls[phase].load( std::memory_order_relaxed )+1 , std::memory_order_relaxed );
+		block.nanoseconds[phase].store( block.nanoseconds[phase].load( std::memory_order_relaxed )+nanoseconds , std::memory_order_relaxed );
+		int bucket = 0;
+		while ( bucket < HISTOGRAM_BUCKETS-1 && ( nanoseconds >> ( bucket+1 ) ) ) ++bucket;
+		block.histogram[phase][bucket].store( block.histogram[phase][bucket].load( std::memory_order_relaxed )+1 , std::memory_order_relaxed );
+	}
+
+private:
+	static thread_local Block threadBlock;
+#endif
+};
+
+
+
+#ifdef LCHESS_INSTRUMENTATION
+/*
+measures the time from its construction or the last call to next until the next call to next or its destruction
+*/
+class lchessMeasurement
+{
+public:
+	lchessMeasurement( const lchessPhase phase ) : phase( phase ) , start( std::chrono::steady_clock::now() ) {}
+	~lchessMeasurement() { this->stop(); }
+
+	// ends the current phase and starts the next one
+	inline void next( const lchessPhase phase )
+	{
+		this->stop();
+		this->phase = phase;
+	}
+
+private:
+	lchessPhase phase;
+	std::chrono::steady_clock::time_point start;
+
+	inline void stop()
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		lchessInstrumentation::record( this->phase , uint64_t( std::chrono::duration_cast<std::chrono::nanoseconds>( now-this->start ).count() ) );
+		this->start = now;
+	}
+};
+
+#define LCHESS_MEASURE( phase ) lchessMeasurement lchessScopedMeasurement( phase )
+#define LCHESS_MEASURE_NEXT( phase ) lchessScopedMeasurement.next( phase )
+#else
+#define LCHESS_MEASURE( phase )
+#define LCHESS_MEASURE_NEXT( phase )
+#endif
@@ -0,0 +1,270 @@
+/*
+use at own risk
+*/
+#include "lchessNetwork.hpp"
+
+#include "lchessBoard.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef LCHESS_AVX2
+#include <immintrin.h>
+#endif
+
+
+
+const lchessNetwork::Kernels lchessNetwork::kernels = lchessNetwork::selectKernels();
+
+
+
+lchessNetwork::lchessNetwork()
+{
+	this->loaded = false;
+	this->outputBias = 0;
+}
+
+
+
+lchessNetwork::~lchessNetwork()
+{
+
+}
+
+
+
+bool lchessNetwork::load( const std::string& path )
+{
+	this->loaded = false;
+
+	std::ifstream file( path , std::ios::binary );
+	if ( !file )
+	{
+		std::cout << "lchessNetwork > load > could not open " << path << std::endl;
+		return false;
+	}
+
+	char magic[4] = {};
+	uint32_t header[5] = {};
+	file.read( magic , 4 );
+	file.read( reinterpret_cast<char*>( header ) , sizeof( header ) );
+	if ( !file || memcmp( magic , "LCNN" , 4 ) != 0 || header[0] != 1 )
+	{
+		std::cout << "lchessNetwork > load > " << path << " is not a version 1 network file" << std::endl;
+		return false;
+	}
+	if ( header[1] != FEATURES || header[2] != HIDDEN || header[3] != LAYER1 || header[4] != LAYER2 )
+	{
+		std::cout << "lchessNetwork > load > " << path << " has the sizes " << header[1] << " " << header[2] << " " << header[3] << " " << header[4] << ", expected " << FEATURES << " " << HIDDEN << " " << LAYER1 << " " << LAYER2 << std::endl;
+		return false;
+	}
+
+	auto read = [&file]( auto& values , const size_t count )
+	{
+		values.resize( count );
+		file.read( reinterpret_cast<char*>( values.data() ) , count*sizeof( values[0] ) );
+	};
+	read( this->featureWeights , size_t( FEATURES )*HIDDEN );
+	read( this->featureBiases , HIDDEN );
+	read( this->layer1Weights , LAYER1*2*HIDDEN );
+	read( this->layer1Biases , LAYER1 );
+	read( this->layer2Weights , LAYER2*LAYER1 );
+	read( this->layer2Biases , LAYER2 );
+	read( this->outputWeights , LAYER2 );
+	file.read( reinterpret_cast<char*>( &this->outputBias ) , sizeof( this->outputBias ) );
+
+	// the file has to end exactly after the last value
+	if ( !file || file.peek() != std::char_traits<char>::eof() )
+	{
+		std::cout << "lchessNetwork > load > " << path << " does not have the size of the network" << std::endl;
+		return false;
+	}
+
+	this->loaded = true;
+	return true;
+}
+
+
+
+void lchessNetwork::refresh( lchessAccumulator& accumulator , const int perspective , const lchessBoard& board ) const
+{
+	memcpy( accumulator.values[perspective] , this->featureBiases.data() , sizeof( accumulator.values[perspective] ) );
+
+	// without a king there is no bucket, the row is refreshed again when the king is put back
+	const int kingSquare = board.getKingSquare( perspective ? BLACK : WHITE );
+	if ( kingSquare == NO_SQUARE ) return;
+
+	uint64_t pieces = board.getOccupied();
+	while ( pieces )
+	{
+		const int index = lchessBitboard::popLsb( pieces );
+		this->addFeature( accumulator , perspective , featureIndex( perspective , board.getPiece( index ) , index , kingSquare ) );
+	}
+}
+
+
+
+int lchessNetwork::evaluate( const lchessAccumulator& accumulator , const BYTE sideToMove ) const
+{
+	const int us = ( sideToMove == WHITE ) ? 0 : 1;
+
+	alignas( 32 ) uint8_t input[2*HIDDEN];
+	kernels.clamp( accumulator.values[us] , input );
+	kernels.clamp( accumulator.values[us^1] , input+HIDDEN );
+
+	alignas( 32 ) int32_t sums[LAYER1 > LAYER2 ? LAYER1 : LAYER2];
+	alignas( 32 ) uint8_t hidden1[LAYER1];
+	kernels.layer( input , 2*HIDDEN , this->layer1Weights.data() , this->layer1Biases.data() , sums , LAYER1 );
+	for ( int i = 0 ; i < LAYER1 ; ++i ) hidden1[i] = uint8_t( std::min( std::max( sums[i] >> WEIGHT_SHIFT , 0 ) , 127 ) );
+
+	alignas( 32 ) uint8_t hidden2[LAYER2];
+	kernels.layer( hidden1 , LAYER1 , this->layer2Weights.data() , this->layer2Biases.data() , sums , LAYER2 );
+	for ( int i = 0 ; i < LAYER2 ; ++i ) hidden2[i] = uint8_t( std::min( std::max( sums[i] >> WEIGHT_SHIFT , 0 ) , 127 ) );
+
+	int32_t output = this->outputBias;
+	for ( int i = 0 ; i < LAYER2 ; ++i ) output += int32_t( hidden2[i] )*this->outputWeights[i];
+	return output/OUTPUT_SCALE;
+}
+
+
+
+/*
+private functions
+*/
+
+
+
+lchessNetwork::Kernels lchessNetwork::selectKernels()
+{
+#ifdef LCHESS_AVX2
+	// this runs during static initialization, before the cpu model is initialized by the runtime
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports( "avx2" ) ) return { addAvx2 , subtractAvx2 , subtractAddAvx2 , clampAvx2 , layerAvx2 };
+#endif
+	return { addScalar , subtractScalar , subtractAddScalar , clampScalar , layerScalar };
+}
+
+
+
+void lchessNetwork::addScalar( int16_t* values , const int16_t* weights )
+{
+	for ( int i = 0 ; i < HIDDEN ; ++i ) values[i] = int16_t( values[i]+weights[i] );
+}
+
+
+
+void lchessNetwork::subtractScalar( int16_t* values , const int16_t* weights )
+{
+	for ( int i = 0 ; i < HIDDEN ; ++i ) values[i] = int16_t( values[i]-weights[i] );
+}
+
+
+
+void lchessNetwork::subtractAddScalar( int16_t* values , const int16_t* removed , const int16_t* added )
+{
+	for ( int i = 0 ; i < HIDDEN ; ++i ) values[i] = int16_t( values[i]-removed[i]+added[i] );
+}
+
+
+
+void lchessNetwork::clampScalar( const int16_t* values , uint8_t* output )
+{
+	for ( int i = 0 ; i < HIDDEN ; ++i ) output[i] = uint8_t( std::min( std::max( int( values[i] ) , 0 ) , 127 ) );
+}
+
+
+
+void lchessNetwork::layerScalar( const uint8_t* input , const int inputs , const int8_t* weights , const int32_t* biases , int32_t* output , const int outputs )
+{
+	for ( int o = 0 ; o < outputs ; ++o )
+	{
+		int32_t sum = biases[o];
+		const int8_t* row = weights+o*inputs;
+		for ( int i = 0 ; i < inputs ; ++i ) sum += int32_t( input[i] )*row[i];
+		output[o] = sum;
+	}
+}
+
+
+
+#ifdef LCHESS_AVX2
+// 16 values per register, the accumulator wraps around on overflow like the scalar code
+__attribute__(( target( "avx2" ) ))
+void lchessNetwork::addAvx2( int16_t* values , const int16_t* weights )
+{
+	__m256i* v = reinterpret_cast<__m256i*>( values );
+	const __m256i* w = reinterpret_cast<const __m256i*>( weights );
+	for ( int i = 0 ; i < HIDDEN/16 ; ++i ) _mm256_store_si256( v+i , _mm256_add_epi16( _mm256_load_si256( v+i ) , _mm256_loadu_si256( w+i ) ) );
+}
+
+
+
+__attribute__(( target( "avx2" ) ))
+void lchessNetwork::subtractAvx2( int16_t* values , const int16_t* weights )
+{
+	__m256i* v = reinterpret_cast<__m256i*>( values );
+	const __m256i* w = reinterpret_cast<const __m256i*>( weights );
+	for ( int i = 0 ; i < HIDDEN/16 ; ++i ) _mm256_store_si256( v+i , _mm256_sub_epi16( _mm256_load_si256( v+i ) , _mm256_loadu_si256( w+i ) ) );
+}
+
+
+
+__attribute__(( target( "avx2" ) ))
+void lchessNetwork::subtractAddAvx2( int16_t* values , const int16_t* removed , const int16_t* added )
+{
+	__m256i* v = reinterpret_cast<__m256i*>( values );
+	const __m256i* r = reinterpret_cast<const __m256i*>( removed );
+	const __m256i* a = reinterpret_cast<const __m256i*>( added );
+	for ( int i = 0 ; i < HIDDEN/16 ; ++i ) _mm256_store_si256( v+i , _mm256_add_epi16( _mm256_sub_epi16( _mm256_load_si256( v+i ) , _mm256_loadu_si256( r+i ) ) , _mm256_loadu_si256( a+i ) ) );
+}
+
+
+
+// packing two registers of 16 bit values into bytes interleaves their 128 bit halves, the permute puts them back in
+// order
+__attribute__(( target( "avx2" ) ))
+void lchessNetwork::clampAvx2( const int16_t* values , uint8_t* output )
+{
+	const __m256i* v = reinterpret_cast<const __m256i*>( values );
+	__m256i* out = reinterpret_cast<__m256i*>( output );
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i limit = _mm256_set1_epi16( 127 );
+	for ( int i = 0 ; i < HIDDEN/32 ; ++i )
+	{
+		const __m256i low = _mm256_min_epi16( _mm256_max_epi16( _mm256_load_si256( v+2*i ) , zero ) , limit );
+		const __m256i high = _mm256_min_epi16( _mm256_max_epi16( _mm256_load_si256( v+2*i+1 ) , zero ) , limit );
+		_mm256_store_si256( out+i , _mm256_permute4x64_epi64( _mm256_packus_epi16( low , high ) , 0xD8 ) );
+	}
+}
+
+
+
+// the inputs are at most 127 and the weights at least -128, so the pairs summed by maddubs never saturate, eight
+// outputs are summed at once and their registers are folded into one with horizontal adds
+__attribute__(( target( "avx2" ) ))
+void lchessNetwork::layerAvx2( const uint8_t* input , const int inputs , const int8_t* weights , const int32_t* biases , int32_t* output , const int outputs )
+{
+	const __m256i ones = _mm256_set1_epi16( 1 );
+	for ( int o = 0 ; o < outputs ; o += 8 )
+	{
+		__m256i sums[8];
+		for ( int k = 0 ; k < 8 ; ++k ) sums[k] = _mm256_setzero_si256();
+		for ( int i = 0 ; i < inputs ; i += 32 )
+		{
+			const __m256i in = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input+i ) );
+			for ( int k = 0 ; k < 8 ; ++k )
+			{
+				const __m256i row = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( weights+( o+k )*inputs+i ) );
+				sums[k] = _mm256_add_epi32( sums[k] , _mm256_madd_epi16( _mm256_maddubs_epi16( in , row ) , ones ) );
+			}
+		}
+
+		// every 128 bit half ends up with the partial sums of all eight outputs in order
+		const __m256i sum0123 = _mm256_hadd_epi32( _mm256_hadd_epi32( sums[0] , sums[1] ) , _mm256_hadd_epi32( sums[2] , sums[3] ) );
+		const __m256i sum4567 = _mm256_hadd_epi32( _mm256_hadd_epi32( sums[4] , sums[5] ) , _mm256_hadd_epi32( sums[6] , sums[7] ) );
+		const __m256i total = _mm256_add_epi32( _mm256_permute2x128_si256( sum0123 , sum4567 , 0x20 ) , _mm256_permute2x128_si256( sum0123 , sum4567 , 0x31 ) );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( output+o ) , _mm256_add_epi32( total , _mm256_loadu_si256( reinterpret_cast<const __m256i*>( biases+o ) ) ) );
+	}
+}
+#endif
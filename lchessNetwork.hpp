@@ -0,0 +1,147 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+class lchessBoard;
+struct lchessAccumulator;
+
+
+
+/*
+a small quantized neural network evaluation
+
+every piece is a feature seen from both sides, relative to the king bucket of that side, the features of a side sum up
+to a row of 256 int16 values in the accumulator, the evaluation clamps the row of the side to move and the row of the
+other side to 0 to 127 and runs them through two hidden layers of 32 neurons with int8 weights to one output
+
+a weight file starts with the four bytes LCNN, the version 1 and the sizes FEATURES, HIDDEN, LAYER1 and LAYER2 as
+uint32, followed by the little endian arrays
+	int16 feature weights [FEATURES][HIDDEN]	int16 feature biases [HIDDEN]
+	int8 layer 1 weights [LAYER1][2*HIDDEN]		int32 layer 1 biases [LAYER1]
+	int8 layer 2 weights [LAYER2][LAYER1]		int32 layer 2 biases [LAYER2]
+	int8 output weights [LAYER2]				int32 output bias
+the hidden layer sums are shifted right by WEIGHT_SHIFT before they are clamped, the output divided by OUTPUT_SCALE is
+the score in centipawns for the side to move
+*/
+class lchessNetwork
+{
+public:
+	static constexpr int KING_BUCKETS = 4;
+	static constexpr int FEATURES = KING_BUCKETS*12*64;
+	static constexpr int HIDDEN = 256;
+	static constexpr int LAYER1 = 32;
+	static constexpr int LAYER2 = 32;
+	static constexpr int WEIGHT_SHIFT = 6;
+	static constexpr int OUTPUT_SCALE = 16;
+
+	lchessNetwork();
+	virtual ~lchessNetwork();
+
+	// reads the weights from a file, prints what went wrong and returns false if the file does not fit the network
+	bool load( const std::string& path );
+	inline bool isLoaded() const { return this->loaded; }
+
+	// the bucket of a king square seen from the given side, queen or king side and whether the king left the first
+	// two ranks
+	static inline int kingBucket( const int perspective , const int kingSquare )
+	{
+		const int index = perspective ? kingSquare^56 : kingSquare;
+		return ( ( index >> 3 ) >= 2 ? 2 : 0 )+( ( index & 7 ) >= 4 ? 1 : 0 );
+	}
+
+	// the feature of a piece seen from the given side, the board is flipped for black so both sides see their own
+	// pieces first and moving up the board
+	static inline int featureIndex( const int perspective , const BYTE piece , const int index , const int kingSquare )
+	{
+		const int relative = ( ( ( piece >> 5 ) & 1 ) == perspective ? 0 : 6 )+( piece & PIECE_TYPE_MASK );
+		return ( kingBucket( perspective , kingSquare )*12+relative )*64+( perspective ? index^56 : index );
+	}
+
+	inline void addFeature( lchessAccumulator& accumulator , const int perspective , const int feature ) const;
+	inline void removeFeature( lchessAccumulator& accumulator , const int perspective , const int feature ) const;
+	// both in one pass over the row, for a piece that moves
+	inline void moveFeature( lchessAccumulator& accumulator , const int perspective , const int removed , const int added ) const;
+
+	// recomputes the row of one side from all pieces on the board
+	void refresh( lchessAccumulator& accumulator , const int perspective , const lchessBoard& board ) const;
+
+	// the score in centipawns for the side to move
+	int evaluate( const lchessAccumulator& accumulator , const BYTE sideToMove ) const;
+
+private:
+	bool loaded;
+
+	std::vector<int16_t> featureWeights;
+	std::vector<int16_t> featureBiases;
+	std::vector<int8_t> layer1Weights;
+	std::vector<int32_t> layer1Biases;
+	std::vector<int8_t> layer2Weights;
+	std::vector<int32_t> layer2Biases;
+	std::vector<int8_t> outputWeights;
+	int32_t outputBias;
+
+	// the loops over the accumulator and the layers, picked once at startup depending on what the cpu supports
+	struct Kernels
+	{
+		void (*add)( int16_t* values , const int16_t* weights );
+		void (*subtract)( int16_t* values , const int16_t* weights );
+		void (*subtractAdd)( int16_t* values , const int16_t* removed , const int16_t* added );
+		// clamps a row of the accumulator to 0 to 127
+		void (*clamp)( const int16_t* values , uint8_t* output );
+		// output = biases + weights * input, inputs has to be a multiple of 32 and outputs a multiple of 8
+		void (*layer)( const uint8_t* input , const int inputs , const int8_t* weights , const int32_t* biases , int32_t* output , const int outputs );
+	};
+
+	static const Kernels kernels;
+
+	static Kernels selectKernels();
+
+	static void addScalar( int16_t* values , const int16_t* weights );
+	static void subtractScalar( int16_t* values , const int16_t* weights );
+	static void subtractAddScalar( int16_t* values , const int16_t* removed , const int16_t* added );
+	static void clampScalar( const int16_t* values , uint8_t* output );
+	static void layerScalar( const uint8_t* input , const int inputs , const int8_t* weights , const int32_t* biases , int32_t* output , const int outputs );
+#ifdef LCHESS_AVX2
+	static void addAvx2( int16_t* values , const int16_t* weights );
+	static void subtractAvx2( int16_t* values , const int16_t* weights );
+	static void subtractAddAvx2( int16_t* values , const int16_t* removed , const int16_t* added );
+	static void clampAvx2( const int16_t* values , uint8_t* output );
+	static void layerAvx2( const uint8_t* input , const int inputs , const int8_t* weights , const int32_t* biases , int32_t* output , const int outputs );
+#endif
+};
+
+
+
+/*
+the first layer of the network for both sides, the board keeps it up to date while pieces move so an evaluation only
+has to run the small layers behind it
+*/
+struct alignas( 32 ) lchessAccumulator
+{
+	// indexed by perspective, 0 for white and 1 for black
+	int16_t values[2][lchessNetwork::HIDDEN];
+};
+
+
+
+inline void lchessNetwork::addFeature( lchessAccumulator& accumulator , const int perspective , const int feature ) const
+{
+	kernels.add( accumulator.values[perspective] , &this->featureWeights[size_t( feature )*HIDDEN] );
+}
+
+
+
+inline void lchessNetwork::removeFeature( lchessAccumulator& accumulator , const int perspective , const int feature ) const
+{
+	kernels.subtract( accumulator.values[perspective] , &this->featureWeights[size_t( feature )*HIDDEN] );
+}
+
+
+
+inline void lchessNetwork::moveFeature( lchessAccumulator& accumulator , const int perspective , const int removed , const int added ) const
+{
+	kernels.subtractAdd( accumulator.values[perspective] , &this->featureWeights[size_t( removed )*HIDDEN] , &this->featureWeights[size_t( added )*HIDDEN] );
+}
@@ -0,0 +1,319 @@
+/*
+use at own risk
+*/
+#include "lchessPerft.hpp"
+
+#include <iomanip>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+
+
+const lchessPerft::Position lchessPerft::suite[] =
+{
+	{ "start" , "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" , { 20 , 400 , 8902 , 197281 , 4865609 , 119060324 } },
+	{ "kiwipete" , "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" , { 48 , 2039 , 97862 , 4085603 , 193690690 , 0 } },
+	{ "position 3" , "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" , { 14 , 191 , 2812 , 43238 , 674624 , 11030083 } },
+	{ "position 4" , "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" , { 6 , 264 , 9467 , 422333 , 15833292 , 0 } },
+	{ "position 4 mirrored" , "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1" , { 6 , 264 , 9467 , 422333 , 15833292 , 0 } },
+	{ "position 5" , "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8" , { 44 , 1486 , 62379 , 2103487 , 89941194 , 0 } },
+	{ "position 6" , "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10" , { 46 , 2079 , 89890 , 3894594 , 164075551 , 0 } },
+};
+
+const int lchessPerft::suiteSize = sizeof( lchessPerft::suite )/sizeof( lchessPerft::suite[0] );
+
+
+
+// a part of the tree, the moves lead from the root to the subtree and depth plies are counted below them
+struct lchessPerftTask
+{
+	lchessCompactMove moves[2];
+	int count;
+	int depth;
+};
+
+// every thread owns a board and a queue, it takes its own tasks from the back and steals from the front of the other
+// queues when its own is empty, so thieves get the oldest and largest tasks
+struct alignas( 64 ) lchessPerftWorker
+{
+	lchessBoard board;
+	std::deque< lchessPerftTask > tasks;
+	std::mutex mutex;
+	uint64_t nodes;
+};
+
+
+
+lchessPerftCache::lchessPerftCache( const size_t megabytes )
+{
+	size_t count = 1;
+	while ( count*2*sizeof( Bucket ) <= megabytes*1024*1024 ) count *= 2;
+	this->buckets.reset( new Bucket[count] );
+	this->mask = count-1;
+	this->clear();
+}
+
+
+
+bool lchessPerftCache::probe( const uint64_t hash , const int depth , uint64_t& nodes ) const
+{
+	const Bucket& bucket = this->buckets[hash & this->mask];
+	for ( const Entry& entry : bucket.entries )
+	{
+		const uint64_t data = entry.data.load( std::memory_order_relaxed );
+		if ( ( entry.key.load( std::memory_order_relaxed ) ^ data ) == hash && int( data & 0xFF ) == depth )
+		{
+			nodes = data >> 8;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+void lchessPerftCache::store( const uint64_t hash , const int depth , const uint64_t nodes )
+{
+	Bucket& bucket = this->buckets[hash & this->mask];
+	const uint64_t data = ( nodes << 8 ) | uint64_t( depth );
+
+	// replace by depth, shallower subtrees go to the second entry
+	Entry& deepest = bucket.entries[0];
+	Entry& entry = ( depth >= int( deepest.data.load( std::memory_order_relaxed ) & 0xFF ) ) ? deepest : bucket.entries[1];
+	entry.key.store( hash ^ data , std::memory_order_relaxed );
+	entry.data.store( data , std::memory_order_relaxed );
+}
+
+
+
+void lchessPerftCache::clear()
+{
+	for ( uint64_t i = 0 ; i <= this->mask ; ++i )
+	{
+		for ( Entry& entry : this->buckets[i].entries )
+		{
+			entry.key.store( 0 , std::memory_order_relaxed );
+			entry.data.store( 0 , std::memory_order_relaxed );
+		}
+	}
+}
+
+
+
+uint64_t lchessPerft::perft( lchessBoard& board , const int depth , lchessPerftCache* cache )
+{
+	if ( depth == 0 ) return 1;
+
+	// subtrees of depth 1 are cheaper to count than to look up
+	const bool cached = cache && depth >= 2;
+	uint64_t hash = 0;
+	uint64_t nodes = 0;
+	if ( cached )
+	{
+		hash = board.getHash();
+		if ( cache->probe( hash , depth , nodes ) ) return nodes;
+	}
+
+	lchessMoveList moves;
+	board.generateMoves( moves );
+
+	// bulk counting, the moves of the last ply do not have to be played
+	if ( depth == 1 ) return moves.size();
+
+	for ( const lchessCompactMove move : moves )
+	{
+		if ( !board.makeMove( move ) ) continue;
+		nodes += perft( board , depth-1 , cache );
+		board.unmakeMove();
+	}
+
+	if ( cached ) cache->store( hash , depth , nodes );
+	return nodes;
+}
+
+
+
+uint64_t lchessPerft::divide( lchessBoard& board , const int depth , lchessPerftCache* cache )
+{
+	lchessMoveList moves;
+	board.generateMoves( moves );
+
+	uint64_t total = 0;
+	for ( const lchessCompactMove move : moves )
+	{
+		if ( !board.makeMove( move ) ) continue;
+		const uint64_t nodes = perft( board , depth-1 , cache );
+		board.unmakeMove();
+
+		std::cout << move.toString() << ": " << nodes << std::endl;
+		total += nodes;
+	}
+	std::cout << std::endl << "moves: " << moves.size() << std::endl << "nodes: " << total << std::endl;
+	return total;
+}
+
+
+
+uint64_t lchessPerft::parallelPerft( const lchessBoard& board , const int depth , const int threads , std::vector<uint64_t>* threadNodes , lchessPerftCache* cache )
+{
+	// shallow trees are not worth the threads
+	if ( threads <= 1 || depth < 3 )
+	{
+		lchessBoard copy = board;
+		copy.clearUndo();
+		const uint64_t nodes = perft( copy , depth , cache );
+		if ( threadNodes ) threadNodes->assign( 1 , nodes );
+		return nodes;
+	}
+
+	std::vector< lchessPerftWorker > workers( threads );
+	for ( lchessPerftWorker& worker : workers )
+	{
+		worker.board = board;
+		worker.board.clearUndo();
+		worker.nodes = 0;
+	}
+
+	// the root moves are dealt out round robin, the replies are only split off when a root move is taken
+	lchessMoveList moves;
+	workers[0].board.generateMoves( moves );
+	for ( int i = 0 ; i < moves.size() ; ++i )
+	{
+		lchessPerftTask task;
+		task.moves[0] = moves[i];
+		task.count = 1;
+		task.depth = depth-1;
+		workers[i%threads].tasks.push_back( task );
+	}
+
+	// the tasks that are queued or being worked on, the workers stop when there are none left
+	std::atomic< int > pending( moves.size() );
+
+	auto takeTask = [&]( const int index , lchessPerftTask& task ) -> bool
+	{
+		for ( int i = 0 ; i < threads ; ++i )
+		{
+			lchessPerftWorker& victim = workers[(index+i)%threads];
+			std::lock_guard< std::mutex > lock( victim.mutex );
+			if ( victim.tasks.empty() ) continue;
+			if ( i == 0 )
+			{
+				task = victim.tasks.back();
+				victim.tasks.pop_back();
+			}
+			else
+			{
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+			}
+			return true;
+		}
+		return false;
+	};
+
+	auto work = [&]( const int index )
+	{
+		lchessPerftWorker& worker = workers[index];
+		lchessPerftTask task;
+		uint64_t nodes = 0;
+		while ( pending.load( std::memory_order_acquire ) > 0 )
+		{
+			if ( !takeTask( index , task ) )
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			// only the moves the board played are taken back, a task it refused a move of is not counted
+			int played = 0;
+			while ( played < task.count && worker.board.makeMove( task.moves[played] ) ) ++played;
+
+			const bool complete = ( played == task.count );
+			if ( complete && task.count == 1 && task.depth >= 3 )
+			{
+				// split the root move into one task per reply
+				lchessMoveList replies;
+				worker.board.generateMoves( replies );
+				pending.fetch_add( replies.size() , std::memory_order_relaxed );
+				{
+					std::lock_guard< std::mutex > lock( worker.mutex );
+					for ( const lchessCompactMove reply : replies )
+					{
+						lchessPerftTask child = task;
+						child.moves[1] = reply;
+						child.count = 2;
+						child.depth = task.depth-1;
+						worker.tasks.push_back( child );
+					}
+				}
+			}
+			else if ( complete )
+			{
+				nodes += perft( worker.board , task.depth , cache );
+			}
+
+			for ( int i = 0 ; i < played ; ++i ) worker.board.unmakeMove();
+			pending.fetch_sub( 1 , std::memory_order_release );
+		}
+		worker.nodes = nodes;
+	};
+
+	std::vector< std::thread > pool;
+	for ( int i = 1 ; i < threads ; ++i ) pool.emplace_back( work , i );
+	work( 0 );
+	for ( std::thread& thread : pool ) thread.join();
+
+	uint64_t total = 0;
+	if ( threadNodes ) threadNodes->clear();
+	for ( const lchessPerftWorker& worker : workers )
+	{
+		total += worker.nodes;
+		if ( threadNodes ) threadNodes->push_back( worker.nodes );
+	}
+	return total;
+}
+
+
+
+bool lchessPerft::runSuite( const int maxDepth , const int threads , lchessPerftCache* cache )
+{
+	bool passed = true;
+	uint64_t totalNodes = 0;
+	double totalTime = 0;
+
+	for ( int i = 0 ; i < suiteSize ; ++i )
+	{
+		const Position& position = suite[i];
+		lchessBoard board;
+		board.init();
+		if ( !board.loadFen( position.fen ) ) return false;
+
+		std::cout << position.name << " (" << position.fen << ")" << std::endl;
+		for ( int depth = 1 ; depth <= maxDepth && depth <= 6 ; ++depth )
+		{
+			const uint64_t expected = position.nodes[depth-1];
+			if ( expected == 0 ) break;
+
+			Timer timer;
+			timer.start();
+			const uint64_t nodes = ( threads > 1 ) ? parallelPerft( board , depth , threads , nullptr , cache ) : perft( board , depth , cache );
+			const double time = timer.getTime();
+			totalNodes += nodes;
+			totalTime += time;
+
+			std::cout << "  depth " << depth << "  nodes " << std::setw( 10 ) << nodes << "  " << std::fixed << std::setprecision( 3 ) << std::setw( 8 ) << time << "s  " << std::setw( 12 ) << uint64_t( nodes/std::max( time , 1e-9 ) ) << " nps";
+			if ( nodes == expected ) std::cout << "  ok" << std::endl;
+			else
+			{
+				std::cout << "  FAILED, expected " << expected << std::endl;
+				passed = false;
+			}
+		}
+	}
+
+	std::cout << std::endl << "total nodes " << totalNodes << " in " << std::fixed << std::setprecision( 3 ) << totalTime << "s, " << uint64_t( totalNodes/std::max( totalTime , 1e-9 ) ) << " nps" << std::endl;
+	std::cout << ( passed ? "all counts match" : "SOME COUNTS DO NOT MATCH" ) << std::endl;
+	return passed;
+}
@@ -0,0 +1,86 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+#include "lchessBoard.hpp"
+
+#include <atomic>
+#include <memory>
+
+
+
+/*
+a fixed size table of subtree counts keyed by position hash and depth, it is shared by all perft threads without locks,
+the key is stored xor-ed with the data so an entry torn by two threads writing at once does not match any position
+*/
+class lchessPerftCache
+{
+public:
+	// the number of buckets is the largest power of two that fits into the given size
+	lchessPerftCache( const size_t megabytes );
+
+	// returns true and sets nodes if the count of the subtree is known
+	bool probe( const uint64_t hash , const int depth , uint64_t& nodes ) const;
+	void store( const uint64_t hash , const int depth , const uint64_t nodes );
+
+	void clear();
+
+	inline size_t getSize() const { return ( this->mask+1 )*sizeof( Bucket ); }
+
+private:
+	// the depth is kept in the low 8 bits of the data, the node count in the rest
+	struct Entry
+	{
+		std::atomic<uint64_t> key;
+		std::atomic<uint64_t> data;
+	};
+
+	// the first entry keeps the deepest subtree seen, the second one the most recent one that was not deep enough
+	struct Bucket
+	{
+		Entry entries[2];
+	};
+
+	std::unique_ptr<Bucket[]> buckets;
+	uint64_t mask;
+};
+
+
+
+/*
+counts the leaf nodes of the legal move tree to a fixed depth, the counts of the reference positions are well known so
+any difference points to a bug in the move generation or in makeMove and unmakeMove
+*/
+class lchessPerft
+{
+public:
+	// a position with its known node counts for depth 1 to 6, 0 where the count is not part of the suite
+	struct Position
+	{
+		const char* name;
+		const char* fen;
+		uint64_t nodes[6];
+	};
+
+	static const Position suite[];
+	static const int suiteSize;
+
+	// the number of leaf nodes depth plies below the position, the last ply is counted with the size of the move list
+	// instead of playing the moves, with a cache every subtree that was counted before is looked up instead
+	static uint64_t perft( lchessBoard& board , const int depth , lchessPerftCache* cache = nullptr );
+
+	// perft below every legal move, printed with one line per move, returns the total
+	static uint64_t divide( lchessBoard& board , const int depth , lchessPerftCache* cache = nullptr );
+
+	// perft spread over several threads, every thread works on its own copy of the board, the subtrees below the root
+	// moves and below their replies are handed out as tasks and idle threads steal tasks from busy ones, the nodes
+	// counted by each thread are written to threadNodes if it is given
+	static uint64_t parallelPerft( const lchessBoard& board , const int depth , const int threads , std::vector<uint64_t>* threadNodes = nullptr , lchessPerftCache* cache = nullptr );
+
+	// runs every suite position up to maxDepth and prints the counts with nodes per second, returns false if any
+	// count differs from the expected one
+	static bool runSuite( const int maxDepth , const int threads = 1 , lchessPerftCache* cache = nullptr );
+};
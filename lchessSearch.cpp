@@ -0,0 +1,398 @@
+/*
+use at own risk
+*/
+#include "lchessSearch.hpp"
+
+#include <algorithm>
+#include <thread>
+
+
+
+std::string lchessSearchResult::pvString() const
+{
+	std::string line;
+	for ( const lchessCompactMove move : this->pv )
+	{
+		if ( !line.empty() ) line += " ";
+		line += move.toString();
+	}
+	return line;
+}
+
+
+
+lchessSearch::lchessSearch( const size_t hashMegabytes , const int threads )
+{
+	this->table.resize( hashMegabytes );
+	this->threads = std::max( 1 , threads );
+	this->stopped = false;
+}
+
+
+
+lchessSearch::~lchessSearch()
+{
+
+}
+
+
+
+lchessSearchResult lchessSearch::search( const lchessBoard& board , const lchessSearchLimits& limits , const std::function<void( const lchessSearchResult& )>& info )
+{
+	this->limits = limits;
+	this->stopped = false;
+	this->timer.start();
+	this->table.newSearch();
+
+	// the workers are kept between searches, the board and principal variation tables are too large to allocate for
+	// every search
+	while ( int( this->workers.size() ) < this->threads ) this->workers.emplace_back( new Worker() );
+	for ( int i = 0 ; i < this->threads ; ++i )
+	{
+		Worker& worker = *this->workers[i];
+		worker.id = i;
+		// the moves the caller played before do not have to be taken back, the search only needs the room
+		worker.board = board;
+		worker.board.clearUndo();
+		worker.nodes = 0;
+	}
+
+	lchessSearchResult result;
+
+	// a position without legal moves has nothing to search
+	lchessMoveList rootMoves;
+	board.generateMoves( rootMoves );
+	if ( rootMoves.empty() )
+	{
+		result.score = isInCheck( board ) ? -MATE_SCORE : 0;
+		return result;
+	}
+	result.bestMove = rootMoves[0];
+
+	// the helpers search until the main thread is done
+	std::vector<std::thread> helpers;
+	std::vector<lchessSearchResult> helperResults( this->threads );
+	for ( int i = 1 ; i < this->threads ; ++i )
+	{
+		helpers.emplace_back( [this,i,&helperResults]() { this->iterate( *this->workers[i] , helperResults[i] , nullptr ); } );
+	}
+
+	this->iterate( *this->workers[0] , result , info );
+
+	this->stopped = true;
+	for ( std::thread& helper : helpers ) helper.join();
+
+	result.threadNodes.clear();
+	for ( int i = 0 ; i < this->threads ; ++i ) result.threadNodes.push_back( this->workers[i]->nodes );
+	result.nodes = this->totalNodes();
+	result.time = this->timer.getTime();
+	result.hashfull = this->table.hashfull();
+	return result;
+}
+
+
+
+/*
+private functions
+*/
+
+
+
+void lchessSearch::iterate( Worker& worker , lchessSearchResult& result , const std::function<void( const lchessSearchResult& )>& info )
+{
+	// the helpers skip depths in a pattern that differs between neighbouring threads, so at any time some of them are
+	// one or two plies ahead of the main thread and fill the table with the results it is about to need
+	static const int skipSize[20] = { 1 , 1 , 2 , 2 , 2 , 2 , 3 , 3 , 3 , 3 , 3 , 3 , 4 , 4 , 4 , 4 , 4 , 4 , 4 , 4 };
+	static const int skipPhase[20] = { 0 , 1 , 0 , 1 , 2 , 3 , 0 , 1 , 2 , 3 , 4 , 5 , 0 , 1 , 2 , 3 , 4 , 5 , 6 , 7 };
+	const bool main = ( worker.id == 0 );
+
+	const int maxDepth = ( main && this->limits.depth > 0 ) ? std::min( this->limits.depth , MAX_PLY-1 ) : MAX_PLY-1;
+	for ( int depth = 1 ; depth <= maxDepth && !this->stopped ; ++depth )
+	{
+		if ( !main )
+		{
+			const int pattern = ( worker.id-1 ) % 20;
+			if ( ( ( depth+skipPhase[pattern] )/skipSize[pattern] ) % 2 ) continue;
+		}
+
+		const int score = this->alphaBeta( worker , depth , 0 , -INFINITE_SCORE , INFINITE_SCORE );
+
+		// an interrupted iteration is thrown away, unless no iteration finished yet and it has a fully searched root
+		// move, which can happen with a tight limit and a large quiescence search
+		if ( this->stopped )
+		{
+			if ( result.depth == 0 && worker.pvLength[0] > 0 ) result.bestMove = worker.pv[0][0];
+			break;
+		}
+
+		// without a root move above the full window the first legal move stays the best one
+		if ( worker.pvLength[0] > 0 ) result.bestMove = worker.pv[0][0];
+		result.score = score;
+		result.depth = depth;
+		result.pv.assign( worker.pv[0] , worker.pv[0]+worker.pvLength[0] );
+		if ( !main ) continue;
+
+		result.nodes = this->totalNodes();
+		result.time = this->timer.getTime();
+		result.hashfull = this->table.hashfull();
+		if ( info ) info( result );
+
+		// a found mate does not get shorter with more depth, and an iteration started after half the time is spent
+		// would most likely not finish
+		if ( isMateScore( score ) && MATE_SCORE-std::abs( score ) <= depth ) break;
+		if ( this->limits.time > 0 && result.time*1000.0 > this->limits.time*0.5 ) break;
+	}
+}
+
+
+
+int lchessSearch::alphaBeta( Worker& worker , int depth , const int ply , int alpha , const int beta )
+{
+	lchessBoard& board = worker.board;
+	worker.pvLength[ply] = ply;
+
+	if ( worker.id == 0 && ( worker.nodes.load( std::memory_order_relaxed ) & 2047 ) == 0 ) this->checkLimits();
+	if ( this->stopped ) return 0;
+
+	const bool inCheck = isInCheck( board );
+	// a check is searched one ply deeper so the quiescence search never starts in check at the horizon
+	if ( inCheck ) ++depth;
+	if ( depth <= 0 ) return this->quiescence( worker , ply , alpha , beta );
+
+	worker.addNode();
+
+	if ( ply > 0 )
+	{
+		if ( board.isRepetition() || board.getHalfmoveClock() >= 100 || board.isInsufficientMaterial() ) return 0;
+		if ( ply >= MAX_PLY ) return evaluate( board );
+	}
+
+	// a deep enough entry of the same position decides the node without searching it, except on the principal
+	// variation where the line has to be complete
+	const uint64_t hash = board.getHash();
+	const bool pvNode = ( beta-alpha > 1 );
+	lchessTTEntry entry;
+	lchessCompactMove ttMove;
+	if ( this->table.probe( hash , entry ) )
+	{
+		ttMove = entry.move;
+		const int ttScore = scoreFromTable( entry.score , ply );
+		if ( !pvNode && entry.depth >= depth )
+		{
+			if ( entry.bound == BOUND_EXACT ) return ttScore;
+			if ( entry.bound == BOUND_LOWER && ttScore >= beta ) return ttScore;
+			if ( entry.bound == BOUND_UPPER && ttScore <= alpha ) return ttScore;
+		}
+	}
+
+	lchessMoveList moves;
+	board.generateMoves( moves );
+	if ( moves.empty() ) return inCheck ? -MATE_SCORE+ply : 0;
+
+	int scores[MAX_LEGAL_MOVES];
+	scoreMoves( board , moves , scores , ttMove );
+
+	const int originalAlpha = alpha;
+	int bestScore = -INFINITE_SCORE;
+	lchessCompactMove bestMove;
+	for ( int i = 0 ; i < moves.size() ; ++i )
+	{
+		const lchessCompactMove move = pickMove( moves , scores , i );
+
+		// the board only refuses a move with a full undo stack, which the cleared stack of a worker does not reach
+		if ( !board.makeMove( move ) ) continue;
+		// a child above the horizon probes the table, its bucket is loaded while it checks for draws, the quiescence
+		// search below does not use the table
+		if ( depth > 1 ) this->table.prefetch( board.getHash() );
+		int score;
+		// the first move is searched with the full window, the others with a null window around alpha that only
+		// proves them worse, one that turns out better is searched again with the full window
+		if ( i == 0 )
+		{
+			score = -this->alphaBeta( worker , depth-1 , ply+1 , -beta , -alpha );
+		}
+		else
+		{
+			score = -this->alphaBeta( worker , depth-1 , ply+1 , -alpha-1 , -alpha );
+			if ( score > alpha && score < beta ) score = -this->alphaBeta( worker , depth-1 , ply+1 , -beta , -alpha );
+		}
+		board.unmakeMove();
+
+		// the result of an interrupted node is not used
+		if ( this->stopped ) return 0;
+
+		if ( score > bestScore )
+		{
+			bestScore = score;
+			bestMove = move;
+			if ( score > alpha )
+			{
+				alpha = score;
+
+				// the line of this node is the move followed by the line of the child
+				worker.pv[ply][ply] = move;
+				for ( int j = ply+1 ; j < worker.pvLength[ply+1] ; ++j ) worker.pv[ply][j] = worker.pv[ply+1][j];
+				worker.pvLength[ply] = std::max( worker.pvLength[ply+1] , ply+1 );
+
+				if ( alpha >= beta ) break;
+			}
+		}
+	}
+
+	const lchessBound bound = ( bestScore >= beta ) ? BOUND_LOWER : ( bestScore > originalAlpha ) ? BOUND_EXACT : BOUND_UPPER;
+	this->table.store( hash , bestMove , scoreToTable( bestScore , ply ) , depth , bound );
+	return bestScore;
+}
+
+
+
+int lchessSearch::quiescence( Worker& worker , const int ply , int alpha , const int beta )
+{
+	lchessBoard& board = worker.board;
+	worker.pvLength[ply] = ply;
+
+	if ( worker.id == 0 && ( worker.nodes.load( std::memory_order_relaxed ) & 2047 ) == 0 ) this->checkLimits();
+	if ( this->stopped ) return 0;
+
+	worker.addNode();
+
+	if ( ply >= MAX_PLY ) return evaluate( board );
+
+	// in check every evasion is searched, otherwise the side to move may stand pat on the static evaluation and only
+	// captures and promotions are tried to improve on it
+	const bool inCheck = isInCheck( board );
+	int bestScore = -INFINITE_SCORE;
+	if ( !inCheck )
+	{
+		bestScore = evaluate( board );
+		if ( bestScore >= beta ) return bestScore;
+		if ( bestScore > alpha ) alpha = bestScore;
+	}
+
+	lchessMoveList moves;
+	board.generateMoves( moves );
+	if ( moves.empty() ) return inCheck ? -MATE_SCORE+ply : 0;
+
+	int scores[MAX_LEGAL_MOVES];
+	scoreMoves( board , moves , scores , lchessCompactMove() );
+
+	for ( int i = 0 ; i < moves.size() ; ++i )
+	{
+		const lchessCompactMove move = pickMove( moves , scores , i );
+		if ( !inCheck && !isCapture( board , move ) && move.promotionType() != QUEEN ) continue;
+		// a capture that loses material in the exchange on its square can not raise the score above standing pat
+		if ( !inCheck && scores[i] < 0 ) continue;
+
+		if ( !board.makeMove( move ) ) continue;
+		const int score = -this->quiescence( worker , ply+1 , -beta , -alpha );
+		board.unmakeMove();
+
+		if ( this->stopped ) return 0;
+
+		if ( score > bestScore )
+		{
+			bestScore = score;
+			if ( score > alpha )
+			{
+				alpha = score;
+				if ( alpha >= beta ) break;
+			}
+		}
+	}
+	return bestScore;
+}
+
+
+
+int lchessSearch::evaluate( const lchessBoard& board )
+{
+	const int score = board.evaluatePosition();
+	return ( board.getSideToMove() == WHITE ) ? score : -score;
+}
+
+
+
+bool lchessSearch::isInCheck( const lchessBoard& board )
+{
+	return ( board.getSideToMove() == WHITE ) ? board.isWhiteInCheck() : board.isBlackInCheck();
+}
+
+
+
+bool lchessSearch::checkLimits()
+{
+	if ( this->limits.nodes > 0 && this->totalNodes() >= this->limits.nodes ) this->stopped = true;
+	if ( this->limits.time > 0 && this->timer.getTime()*1000.0 >= this->limits.time ) this->stopped = true;
+	return this->stopped;
+}
+
+
+
+uint64_t lchessSearch::totalNodes() const
+{
+	uint64_t nodes = 0;
+	for ( int i = 0 ; i < this->threads ; ++i ) nodes += this->workers[i]->nodes.load( std::memory_order_relaxed );
+	return nodes;
+}
+
+
+
+void lchessSearch::scoreMoves( const lchessBoard& board , const lchessMoveList& moves , int* scores , const lchessCompactMove ttMove )
+{
+	for ( int i = 0 ; i < moves.size() ; ++i )
+	{
+		const lchessCompactMove move = moves[i];
+		if ( move == ttMove ) scores[i] = 1 << 30;
+		else if ( isCapture( board , move ) )
+		{
+			// en passant captures a pawn on a square other than the target
+			const BYTE victim = move.isEnPassant() ? BYTE( PAWN ) : BYTE( board.getPiece( move.to() ) & PIECE_TYPE_MASK );
+			const BYTE attacker = board.getPiece( move.from() ) & PIECE_TYPE_MASK;
+			const int value = lchessBoard::PIECE_VALUES[victim]*16-lchessBoard::PIECE_VALUES[attacker]/16;
+			// taking a piece worth at least as much can not lose material, the exchange is only resolved otherwise
+			const bool losing = lchessBoard::PIECE_VALUES[victim] < lchessBoard::PIECE_VALUES[attacker] && board.staticExchange( move ) < 0;
+			scores[i] = losing ? -( 1 << 20 )+value : ( 1 << 20 )+value;
+		}
+		else if ( move.promotionType() == QUEEN ) scores[i] = 1 << 19;
+		else scores[i] = 0;
+	}
+}
+
+
+
+lchessCompactMove lchessSearch::pickMove( lchessMoveList& moves , int* scores , const int index )
+{
+	int best = index;
+	for ( int i = index+1 ; i < moves.size() ; ++i )
+	{
+		if ( scores[i] > scores[best] ) best = i;
+	}
+	std::swap( moves[index] , moves[best] );
+	std::swap( scores[index] , scores[best] );
+	return moves[index];
+}
+
+
+
+bool lchessSearch::isCapture( const lchessBoard& board , const lchessCompactMove move )
+{
+	return move.isEnPassant() || !board.isEmpty( move.to() );
+}
+
+
+
+int lchessSearch::scoreToTable( const int score , const int ply )
+{
+	if ( score > MATE_BOUND ) return score+ply;
+	if ( score < -MATE_BOUND ) return score-ply;
+	return score;
+}
+
+
+
+int lchessSearch::scoreFromTable( const int score , const int ply )
+{
+	if ( score > MATE_BOUND ) return score-ply;
+	if ( score < -MATE_BOUND ) return score+ply;
+	return score;
+}
@@ -0,0 +1,136 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+#include "lchessBoard.hpp"
+#include "lchessTranspositionTable.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+
+
+// what a search may spend, 0 means no limit, the search stops at whichever limit it reaches first
+struct lchessSearchLimits
+{
+	int depth = 0;
+	uint64_t nodes = 0;
+	// in milliseconds
+	int time = 0;
+};
+
+/*
+the outcome of a search, the best move is a null move if the side to move has no legal move
+*/
+struct lchessSearchResult
+{
+	lchessCompactMove bestMove;
+	int score = 0;
+	int depth = 0;
+	uint64_t nodes = 0;
+	double time = 0.0;
+	// how full the transposition table is in permille
+	int hashfull = 0;
+	// the principal variation, the best line for both sides starting with the best move
+	std::vector<lchessCompactMove> pv;
+	// the nodes searched by each thread, the main thread first
+	std::vector<uint64_t> threadNodes;
+
+	// the moves of the principal variation separated by spaces
+	std::string pvString() const;
+};
+
+
+
+/*
+a negamax alpha-beta search with iterative deepening, every iteration searches one ply deeper with the transposition
+table and the principal variation of the last one ordering the moves, the leaves are resolved with a quiescence search
+of captures that do not lose material and scored with lchessBoard::evaluatePosition from the side to move
+
+with more than one thread the search is lazy smp, the helper threads run the same iterative deepening on their own
+boards at staggered depths and only share what they find through the transposition table, the main thread decides
+when to stop and reports its own line
+*/
+class lchessSearch
+{
+public:
+	static constexpr int MAX_PLY = 128;
+	static constexpr int INFINITE_SCORE = 32000;
+	// a mate in n plies scores MATE_SCORE-n, every score above MATE_BOUND is a mate
+	static constexpr int MATE_SCORE = 31000;
+	static constexpr int MATE_BOUND = MATE_SCORE-MAX_PLY;
+	static_assert( lchessBoard::MAX_EVALUATION == MATE_BOUND-1 , "an evaluation must not look like a mate score" );
+
+	lchessSearch( const size_t hashMegabytes = 16 , const int threads = 1 );
+	virtual ~lchessSearch();
+
+	// the number of threads of the following searches, the main thread included
+	inline void setThreads( const int threads ) { this->threads = std::max( 1 , threads ); }
+	inline int getThreads() const { return this->threads; }
+
+	// searches the position until a limit is reached, the info callback is called after every finished iteration
+	lchessSearchResult search( const lchessBoard& board , const lchessSearchLimits& limits , const std::function<void( const lchessSearchResult& )>& info = nullptr );
+
+	// stops a running search from another thread, the search returns the result of the last finished iteration
+	inline void stop() { this->stopped.store( true , std::memory_order_relaxed ); }
+
+	inline lchessTranspositionTable& getTable() { return this->table; }
+
+	// true if the score is a mate for either side
+	static inline bool isMateScore( const int score ) { return score > MATE_BOUND || score < -MATE_BOUND; }
+
+private:
+	// everything a thread changes while it searches, each one on its own cache lines
+	struct alignas( 64 ) Worker
+	{
+		int id;
+		// the board the thread plays its moves on
+		lchessBoard board;
+		// only written by the thread itself, the main thread reads it for the node limit
+		std::atomic<uint64_t> nodes;
+
+		// the triangular principal variation table, row ply holds the best line found from that ply on
+		lchessCompactMove pv[MAX_PLY+1][MAX_PLY+1];
+		int pvLength[MAX_PLY+1];
+
+		inline void addNode() { this->nodes.store( this->nodes.load( std::memory_order_relaxed )+1 , std::memory_order_relaxed ); }
+	};
+
+	lchessTranspositionTable table;
+	int threads;
+	std::vector< std::unique_ptr<Worker> > workers;
+
+	lchessSearchLimits limits;
+	Timer timer;
+	std::atomic<bool> stopped;
+
+	// the iterative deepening of one thread, only the main thread reports its iterations and stops the others
+	void iterate( Worker& worker , lchessSearchResult& result , const std::function<void( const lchessSearchResult& )>& info );
+
+	int alphaBeta( Worker& worker , int depth , const int ply , int alpha , const int beta );
+	int quiescence( Worker& worker , const int ply , int alpha , const int beta );
+
+	// the evaluation from the side to move
+	static int evaluate( const lchessBoard& board );
+	static bool isInCheck( const lchessBoard& board );
+	// checks the node and time limits and sets stopped when one is reached, the main thread calls it every few
+	// thousand nodes
+	bool checkLimits();
+	uint64_t totalNodes() const;
+
+	// orders the moves by putting the best one first at each step, the transposition table move, then captures with
+	// the most valuable victim and least valuable attacker, then the quiet moves and last the captures that lose
+	// material by the static exchange evaluation, which are the only moves with a negative score
+	static void scoreMoves( const lchessBoard& board , const lchessMoveList& moves , int* scores , const lchessCompactMove ttMove );
+	static lchessCompactMove pickMove( lchessMoveList& moves , int* scores , const int index );
+
+	static bool isCapture( const lchessBoard& board , const lchessCompactMove move );
+
+	// mate scores are stored relative to the node they were found at and not to the root
+	static int scoreToTable( const int score , const int ply );
+	static int scoreFromTable( const int score , const int ply );
+};
@@ -4,6 +4,14 @@ use at own risk
 #include "lchessThreatMap.hpp"
 #include "lchessBoard.hpp"
 
+#ifdef LCHESS_AVX2
+#include <immintrin.h>
+#endif
+
+
+
+const lchessThreatMap::SlidingAttacksFunction lchessThreatMap::slidingAttacks = lchessThreatMap::selectSlidingAttacks();
+
 
 
 lchessThreatMap::lchessThreatMap()
@@ -23,8 +31,10 @@ lchessThreatMap::~lchessThreatMap()
 
 lchessThreatMap lchessThreatMap::fromBoard( const lchessBoard& board )
 {
+	const uint64_t occupied = board.getOccupied();
 	lchessThreatMap threatMap;
-	threatMap.init( board );
+	threatMap.white = int64_t( attacksOf( board , WHITE , occupied ) );
+	threatMap.black = int64_t( attacksOf( board , BLACK , occupied ) );
 	return threatMap;
 }
 
@@ -32,226 +42,49 @@ lchessThreatMap lchessThreatMap::fromBoard( const lchessBoard& board )
 
 bool lchessThreatMap::isWhiteInCheck( const lchessBoard& board )
 {
-	for ( int i = 0 ; i < 64 ; ++i )
-	{
-		if ( board.isBlack( i ) )
-		{
-			BYTE piece = board.getPiece( i );
-			int x = i%8;
-			int y = i/8;
-			if ( piece == BLACK_PAWN )
-			{
-				if ( y > 0 && x-1 >= 0 && board.getPiece(toIndex(x-1,y-1)) == WHITE_KING ) return true;
-				if ( y > 0 && x+1 < 8 && board.getPiece(toIndex(x+1,y-1)) == WHITE_KING ) return true;
-			}
-			else if ( piece == BLACK_KNIGHT )
-			{
-				// up
-				if ( x-1 >= 0 && y+2 < 8 && board.getPiece(toIndex(x-1,y+2)) == WHITE_KING ) return true;
-				if ( x+1 < 8 && y+2 < 8 && board.getPiece(toIndex(x+1,y+2)) == WHITE_KING ) return true;
-
-				// down
-				if ( x-1 >= 0 && y-2 >= 0 && board.getPiece(toIndex(x-1,y-2)) == WHITE_KING ) return true;
-				if ( x+1 < 8 && y-2 >= 0 && board.getPiece(toIndex(x+1,y-2)) == WHITE_KING ) return true;
-
-				// left
-				if ( x-2 >= 0 && y-1 >= 0 && board.getPiece(toIndex(x-2,y-1)) == WHITE_KING ) return true;
-				if ( x-2 >= 0 && y+1 < 8 && board.getPiece(toIndex(x-2,y+1)) == WHITE_KING ) return true;
-
-				// right
-				if ( x+2 < 8 && y-1 >= 0 && board.getPiece(toIndex(x+2,y-1)) == WHITE_KING ) return true;
-				if ( x+2 < 8 && y+1 < 8 && board.getPiece(toIndex(x+2,y+1)) == WHITE_KING ) return true;
-			}
-			else if ( piece == BLACK_ROOK || piece == BLACK_BISHOP || piece == BLACK_QUEEN )
-			{
-				// rook moves
-				if ( piece == BLACK_ROOK || piece == BLACK_QUEEN )
-				{
-					// up
-					for ( int r = y+1 ; r < 8 ; ++r )
-					{
-						if ( board.getPiece(r*8+x) == WHITE_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+x) ) break;
-					}
-
-					// down
-					for ( int r = y-1 ; r >= 0 ; --r )
-					{
-						if ( board.getPiece(r*8+x) == WHITE_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+x) ) break;
-					}
-
-					// left
-					for ( int f = x-1 ; f >= 0 ; --f )
-					{
-						if ( board.getPiece(y*8+f) == WHITE_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(y*8+f) ) break;
-					}
-
-					// right
-					for ( int f = x+1 ; f < 8 ; ++f )
-					{
-						if ( board.getPiece(y*8+f) == WHITE_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(y*8+f) ) break;
-					}
-				}
-
-				// bishop moves
-				if ( piece == BLACK_BISHOP || piece == BLACK_QUEEN )
-				{
-					// down left
-					for ( int r = y-1 , f = x-1 ; r >= 0 && f >= 0 ; --r , --f )
-					{
-						if ( board.getPiece(r*8+f) == WHITE_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// down right
-					for ( int r = y-1 , f = x+1 ; r >= 0 && f < 8 ; --r , ++f )
-					{
-						if ( board.getPiece(r*8+f) == WHITE_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// up left
-					for ( int r = y+1 , f = x-1 ; r < 8 && f >= 0 ; ++r , --f )
-					{
-						if ( board.getPiece(r*8+f) == WHITE_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// up right
-					for ( int r = y+1 , f = x+1 ; r < 8 && f < 8 ; ++r , ++f )
-					{
-						if ( board.getPiece(r*8+f) == WHITE_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-				}
-			}
-		}
-	}
-	return false;
+	const int kingSquare = board.getKingSquare( WHITE );
+	if ( kingSquare == NO_SQUARE ) return false;
+	return board.attackersTo( kingSquare , BLACK ) != 0;
 }
 
 
 
 bool lchessThreatMap::isBlackInCheck( const lchessBoard& board )
 {
-	for ( int i = 0 ; i < 64 ; ++i )
-	{
-		if ( board.isWhite( i ) )
-		{
-			BYTE piece = board.getPiece( i );
-			int x = i%8;
-			int y = i/8;
-			if ( piece == WHITE_PAWN )
-			{
-				if ( y < 7 && x-1 >= 0 && board.getPiece(toIndex(x-1,y+1)) == BLACK_KING ) return true;
-				if ( y < 7 && x+1 < 8 && board.getPiece(toIndex(x+1,y+1)) == BLACK_KING ) return true;
-			}
-			else if ( piece == WHITE_KNIGHT )
-			{
-				// up
-				if ( x-1 >= 0 && y+2 < 8 && board.getPiece(toIndex(x-1,y+2)) == BLACK_KING ) return true;
-				if ( x+1 < 8 && y+2 < 8 && board.getPiece(toIndex(x+1,y+2)) == BLACK_KING ) return true;
-
-				// down
-				if ( x-1 >= 0 && y-2 >= 0 && board.getPiece(toIndex(x-1,y-2)) == BLACK_KING ) return true;
-				if ( x+1 < 8 && y-2 >= 0 && board.getPiece(toIndex(x+1,y-2)) == BLACK_KING ) return true;
-
-				// left
-				if ( x-2 >= 0 && y-1 >= 0 && board.getPiece(toIndex(x-2,y-1)) == BLACK_KING ) return true;
-				if ( x-2 >= 0 && y+1 < 8 && board.getPiece(toIndex(x-2,y+1)) == BLACK_KING ) return true;
-
-				// right
-				if ( x+2 < 8 && y-1 >= 0 && board.getPiece(toIndex(x+2,y-1)) == BLACK_KING ) return true;
-				if ( x+2 < 8 && y+1 < 8 && board.getPiece(toIndex(x+2,y+1)) == BLACK_KING ) return true;
-			}
-			else if ( piece == WHITE_ROOK || piece == WHITE_BISHOP || piece == WHITE_QUEEN )
-			{
-				// rook moves
-				if ( piece == WHITE_ROOK || piece == WHITE_QUEEN )
-				{
-					// up
-					for ( int r = y+1 ; r < 8 ; ++r )
-					{
-						if ( board.getPiece(r*8+x) == BLACK_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+x) ) break;
-					}
-
-					// down
-					for ( int r = y-1 ; r >= 0 ; --r )
-					{
-						if ( board.getPiece(r*8+x) == BLACK_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+x) ) break;
-					}
-
-					// left
-					for ( int f = x-1 ; f >= 0 ; --f )
-					{
-						if ( board.getPiece(y*8+f) == BLACK_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(y*8+f) ) break;
-					}
-
-					// right
-					for ( int f = x+1 ; f < 8 ; ++f )
-					{
-						if ( board.getPiece(y*8+f) == BLACK_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(y*8+f) ) break;
-					}
-				}
-
-				// bishop moves
-				if ( piece == WHITE_BISHOP || piece == WHITE_QUEEN )
-				{
-					// down left
-					for ( int r = y-1 , f = x-1 ; r >= 0 && f >= 0 ; --r , --f )
-					{
-						if ( board.getPiece(r*8+f) == BLACK_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// down right
-					for ( int r = y-1 , f = x+1 ; r >= 0 && f < 8 ; --r , ++f )
-					{
-						if ( board.getPiece(r*8+f) == BLACK_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// up left
-					for ( int r = y+1 , f = x-1 ; r < 8 && f >= 0 ; ++r , --f )
-					{
-						if ( board.getPiece(r*8+f) == BLACK_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// up right
-					for ( int r = y+1 , f = x+1 ; r < 8 && f < 8 ; ++r , ++f )
-					{
-						if ( board.getPiece(r*8+f) == BLACK_KING ) return true;
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-				}
-			}
-		}
-	}
-	return false;
+	const int kingSquare = board.getKingSquare( BLACK );
+	if ( kingSquare == NO_SQUARE ) return false;
+	return board.attackersTo( kingSquare , WHITE ) != 0;
+}
+
+
+
+// pawns and knights are shifted as whole sets, the sliders are filled along their rays until they hit a piece
+uint64_t lchessThreatMap::attacksOf( const lchessBoard& board , const BYTE color , const uint64_t occupancy )
+{
+	const uint64_t notA = ~lchessBitboard::FILE_A;
+	const uint64_t notAB = ~( lchessBitboard::FILE_A | ( lchessBitboard::FILE_A << 1 ) );
+	const uint64_t notH = ~lchessBitboard::FILE_H;
+	const uint64_t notGH = ~( lchessBitboard::FILE_H | ( lchessBitboard::FILE_H >> 1 ) );
+
+	uint64_t attacks = 0;
+
+	const uint64_t pawns = board.getPieces( color | PAWN );
+	if ( color == WHITE ) attacks |= ( ( pawns << 7 ) & notH ) | ( ( pawns << 9 ) & notA );
+	else attacks |= ( ( pawns >> 9 ) & notH ) | ( ( pawns >> 7 ) & notA );
+
+	const uint64_t knights = board.getPieces( color | KNIGHT );
+	attacks |= ( ( knights << 17 ) & notA ) | ( ( knights << 15 ) & notH ) | ( ( knights << 10 ) & notAB ) | ( ( knights << 6 ) & notGH );
+	attacks |= ( ( knights >> 17 ) & notH ) | ( ( knights >> 15 ) & notA ) | ( ( knights >> 10 ) & notGH ) | ( ( knights >> 6 ) & notAB );
+
+	const int kingSquare = board.getKingSquare( color );
+	if ( kingSquare != NO_SQUARE ) attacks |= lchessBitboard::kingAttacks( kingSquare );
+
+	const uint64_t queens = board.getPieces( color | QUEEN );
+	const uint64_t straight = board.getPieces( color | ROOK ) | queens;
+	const uint64_t diagonal = board.getPieces( color | BISHOP ) | queens;
+	if ( straight | diagonal ) attacks |= slidingAttacks( straight , diagonal , ~occupancy );
+
+	return attacks;
 }
 
 
@@ -302,240 +135,92 @@ private functions
 
 
 
-void lchessThreatMap::init( const lchessBoard& board )
+lchessThreatMap::SlidingAttacksFunction lchessThreatMap::selectSlidingAttacks()
+{
+#ifdef LCHESS_AVX2
+	// this runs during static initialization, before the cpu model is initialized by the runtime
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports( "avx2" ) ) return slidingAttacksAvx2;
+#endif
+	return slidingAttacksScalar;
+}
+
+
+
+// kogge-stone occluded fill, every step doubles the distance the sliders have been spread along the empty squares, the
+// masks keep the rays from wrapping around the board edges
+uint64_t lchessThreatMap::slidingAttacksScalar( const uint64_t straight , const uint64_t diagonal , const uint64_t empty )
 {
-	for ( int i = 0 ; i < 64 ; ++i )
+	// shift amounts and wrap masks of north, east, north east and north west, the opposite directions shift right
+	static const int shifts[4] = { 8 , 1 , 9 , 7 };
+	static const uint64_t leftMasks[4] = { ~uint64_t(0) , ~lchessBitboard::FILE_A , ~lchessBitboard::FILE_A , ~lchessBitboard::FILE_H };
+	static const uint64_t rightMasks[4] = { ~uint64_t(0) , ~lchessBitboard::FILE_H , ~lchessBitboard::FILE_H , ~lchessBitboard::FILE_A };
+
+	uint64_t attacks = 0;
+	for ( int d = 0 ; d < 4 ; ++d )
 	{
-		if ( !board.isEmpty( i ) )
-		{
-			BYTE piece = board.getPiece( i );
-			int x = i%8;
-			int y = i/8;
-			if ( piece == WHITE_PAWN )
-			{
-				if ( y < 7 && x-1 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x-1,y+1)) );
-				if ( y < 7 && x+1 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x+1,y+1)) );
-			}
-			else if ( piece == WHITE_KNIGHT )
-			{
-				// up
-				if ( x-1 >= 0 && y+2 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x-1,y+2)) );
-				if ( x+1 < 8 && y+2 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x+1,y+2)) );
-
-				// down
-				if ( x-1 >= 0 && y-2 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x-1,y-2)) );
-				if ( x+1 < 8 && y-2 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x+1,y-2)) );
-
-				// left
-				if ( x-2 >= 0 && y-1 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x-2,y-1)) );
-				if ( x-2 >= 0 && y+1 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x-2,y+1)) );
-
-				// right
-				if ( x+2 < 8 && y-1 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x+2,y-1)) );
-				if ( x+2 < 8 && y+1 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x+2,y+1)) );
-			}
-			else if ( piece == WHITE_KING )
-			{
-				// straight moves
-				if ( y-1 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x,y-1)) );
-				if ( y+1 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x,y+1)) );
-				if ( x-1 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x-1,y)) );
-				if ( x+1 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x+1,y)) );
-
-				// diagonal moves
-				if ( y-1 >= 0 && x-1 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x-1,y-1)) );
-				if ( y-1 >= 0 && x+1 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x+1,y-1)) );
-				if ( y+1 < 8 && x-1 >= 0 ) this->white |= ( int64_t(1) << int64_t(toIndex(x-1,y+1)) );
-				if ( y+1 < 8 && x+1 < 8 ) this->white |= ( int64_t(1) << int64_t(toIndex(x+1,y+1)) );
-			}
-			else if ( piece == WHITE_ROOK || piece == WHITE_BISHOP || piece == WHITE_QUEEN )
-			{
-				// rook moves
-				if ( piece == WHITE_ROOK || piece == WHITE_QUEEN )
-				{
-					// up
-					for ( int r = y+1 ; r < 8 ; ++r )
-					{
-						this->white |= ( int64_t(1) << int64_t(r*8+x) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+x) ) break;
-					}
-
-					// down
-					for ( int r = y-1 ; r >= 0 ; --r )
-					{
-						this->white |= ( int64_t(1) << int64_t(r*8+x) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+x) ) break;
-					}
-
-					// left
-					for ( int f = x-1 ; f >= 0 ; --f )
-					{
-						this->white |= ( int64_t(1) << int64_t(y*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(y*8+f) ) break;
-					}
-
-					// right
-					for ( int f = x+1 ; f < 8 ; ++f )
-					{
-						this->white |= ( int64_t(1) << int64_t(y*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(y*8+f) ) break;
-					}
-				}
-
-				// bishop moves
-				if ( piece == WHITE_BISHOP || piece == WHITE_QUEEN )
-				{
-					// down left
-					for ( int r = y-1 , f = x-1 ; r >= 0 && f >= 0 ; --r , --f )
-					{
-						this->white |= ( int64_t(1) << int64_t(r*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// down right
-					for ( int r = y-1 , f = x+1 ; r >= 0 && f < 8 ; --r , ++f )
-					{
-						this->white |= ( int64_t(1) << int64_t(r*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// up left
-					for ( int r = y+1 , f = x-1 ; r < 8 && f >= 0 ; ++r , --f )
-					{
-						this->white |= ( int64_t(1) << int64_t(r*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// up right
-					for ( int r = y+1 , f = x+1 ; r < 8 && f < 8 ; ++r , ++f )
-					{
-						this->white |= ( int64_t(1) << int64_t(r*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-				}
-			}
-			/*
-			BLACK
-			*/
-			else if ( piece == BLACK_PAWN )
-			{
-				if ( y > 0 && x-1 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x-1,y-1)) );
-				if ( y > 0 && x+1 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x+1,y-1)) );
-			}
-			else if ( piece == BLACK_KNIGHT )
-			{
-				// up
-				if ( x-1 >= 0 && y+2 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x-1,y+2)) );
-				if ( x+1 < 8 && y+2 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x+1,y+2)) );
-
-				// down
-				if ( x-1 >= 0 && y-2 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x-1,y-2)) );
-				if ( x+1 < 8 && y-2 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x+1,y-2)) );
-
-				// left
-				if ( x-2 >= 0 && y-1 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x-2,y-1)) );
-				if ( x-2 >= 0 && y+1 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x-2,y+1)) );
-
-				// right
-				if ( x+2 < 8 && y-1 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x+2,y-1)) );
-				if ( x+2 < 8 && y+1 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x+2,y+1)) );
-			}
-			else if ( piece == BLACK_KING )
-			{
-				// straight moves
-				if ( y-1 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x,y-1)) );
-				if ( y+1 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x,y+1)) );
-				if ( x-1 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x-1,y)) );
-				if ( x+1 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x+1,y)) );
-
-				// diagonal moves
-				if ( y-1 >= 0 && x-1 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x-1,y-1)) );
-				if ( y-1 >= 0 && x+1 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x+1,y-1)) );
-				if ( y+1 < 8 && x-1 >= 0 ) this->black |= ( int64_t(1) << int64_t(toIndex(x-1,y+1)) );
-				if ( y+1 < 8 && x+1 < 8 ) this->black |= ( int64_t(1) << int64_t(toIndex(x+1,y+1)) );
-			}
-			else if ( piece == BLACK_ROOK || piece == BLACK_BISHOP || piece == BLACK_QUEEN )
-			{
-				// rook moves
-				if ( piece == BLACK_ROOK || piece == BLACK_QUEEN )
-				{
-					// up
-					for ( int r = y+1 ; r < 8 ; ++r )
-					{
-						this->black |= ( int64_t(1) << int64_t(r*8+x) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+x) ) break;
-					}
-
-					// down
-					for ( int r = y-1 ; r >= 0 ; --r )
-					{
-						this->black |= ( int64_t(1) << int64_t(r*8+x) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+x) ) break;
-					}
-
-					// left
-					for ( int f = x-1 ; f >= 0 ; --f )
-					{
-						this->black |= ( int64_t(1) << int64_t(y*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(y*8+f) ) break;
-					}
-
-					// right
-					for ( int f = x+1 ; f < 8 ; ++f )
-					{
-						this->black |= ( int64_t(1) << int64_t(y*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(y*8+f) ) break;
-					}
-				}
-
-				// bishop moves
-				if ( piece == BLACK_BISHOP || piece == BLACK_QUEEN )
-				{
-					// down left
-					for ( int r = y-1 , f = x-1 ; r >= 0 && f >= 0 ; --r , --f )
-					{
-						this->black |= ( int64_t(1) << int64_t(r*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// down right
-					for ( int r = y-1 , f = x+1 ; r >= 0 && f < 8 ; --r , ++f )
-					{
-						this->black |= ( int64_t(1) << int64_t(r*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// up left
-					for ( int r = y+1 , f = x-1 ; r < 8 && f >= 0 ; ++r , --f )
-					{
-						this->black |= ( int64_t(1) << int64_t(r*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-
-					// up right
-					for ( int r = y+1 , f = x+1 ; r < 8 && f < 8 ; ++r , ++f )
-					{
-						this->black |= ( int64_t(1) << int64_t(r*8+f) );
-						// stop at any piece
-						if ( !board.isEmpty(r*8+f) ) break;
-					}
-				}
-			}
-		}
+		const int s = shifts[d];
+		const uint64_t sliders = ( d < 2 ) ? straight : diagonal;
+
+		uint64_t gen = sliders;
+		uint64_t pro = empty & leftMasks[d];
+		gen |= pro & ( gen << s );
+		pro &= pro << s;
+		gen |= pro & ( gen << 2*s );
+		pro &= pro << 2*s;
+		gen |= pro & ( gen << 4*s );
+		attacks |= ( gen << s ) & leftMasks[d];
+
+		gen = sliders;
+		pro = empty & rightMasks[d];
+		gen |= pro & ( gen >> s );
+		pro &= pro >> s;
+		gen |= pro & ( gen >> 2*s );
+		pro &= pro >> 2*s;
+		gen |= pro & ( gen >> 4*s );
+		attacks |= ( gen >> s ) & rightMasks[d];
 	}
-}
\ No newline at end of file
+	return attacks;
+}
+
+
+
+#ifdef LCHESS_AVX2
+// the same fill with the four left shifting directions in one register and the four right shifting ones in another,
+// every 64 bit lane walks one direction
+__attribute__(( target( "avx2" ) ))
+uint64_t lchessThreatMap::slidingAttacksAvx2( const uint64_t straight , const uint64_t diagonal , const uint64_t empty )
+{
+	const __m256i shift1 = _mm256_set_epi64x( 7 , 9 , 1 , 8 );
+	const __m256i shift2 = _mm256_add_epi64( shift1 , shift1 );
+	const __m256i shift4 = _mm256_add_epi64( shift2 , shift2 );
+	const __m256i sliders = _mm256_set_epi64x( int64_t( diagonal ) , int64_t( diagonal ) , int64_t( straight ) , int64_t( straight ) );
+	const __m256i emptySquares = _mm256_set1_epi64x( int64_t( empty ) );
+
+	// north, east, north east, north west
+	const __m256i leftMasks = _mm256_set_epi64x( int64_t( ~lchessBitboard::FILE_H ) , int64_t( ~lchessBitboard::FILE_A ) , int64_t( ~lchessBitboard::FILE_A ) , -1 );
+	__m256i gen = sliders;
+	__m256i pro = _mm256_and_si256( emptySquares , leftMasks );
+	gen = _mm256_or_si256( gen , _mm256_and_si256( pro , _mm256_sllv_epi64( gen , shift1 ) ) );
+	pro = _mm256_and_si256( pro , _mm256_sllv_epi64( pro , shift1 ) );
+	gen = _mm256_or_si256( gen , _mm256_and_si256( pro , _mm256_sllv_epi64( gen , shift2 ) ) );
+	pro = _mm256_and_si256( pro , _mm256_sllv_epi64( pro , shift2 ) );
+	gen = _mm256_or_si256( gen , _mm256_and_si256( pro , _mm256_sllv_epi64( gen , shift4 ) ) );
+	__m256i attacks = _mm256_and_si256( _mm256_sllv_epi64( gen , shift1 ) , leftMasks );
+
+	// south, west, south west, south east
+	const __m256i rightMasks = _mm256_set_epi64x( int64_t( ~lchessBitboard::FILE_A ) , int64_t( ~lchessBitboard::FILE_H ) , int64_t( ~lchessBitboard::FILE_H ) , -1 );
+	gen = sliders;
+	pro = _mm256_and_si256( emptySquares , rightMasks );
+	gen = _mm256_or_si256( gen , _mm256_and_si256( pro , _mm256_srlv_epi64( gen , shift1 ) ) );
+	pro = _mm256_and_si256( pro , _mm256_srlv_epi64( pro , shift1 ) );
+	gen = _mm256_or_si256( gen , _mm256_and_si256( pro , _mm256_srlv_epi64( gen , shift2 ) ) );
+	pro = _mm256_and_si256( pro , _mm256_srlv_epi64( pro , shift2 ) );
+	gen = _mm256_or_si256( gen , _mm256_and_si256( pro , _mm256_srlv_epi64( gen , shift4 ) ) );
+	attacks = _mm256_or_si256( attacks , _mm256_and_si256( _mm256_srlv_epi64( gen , shift1 ) , rightMasks ) );
+
+	// fold the four lanes into one bitboard
+	const __m128i half = _mm_or_si128( _mm256_castsi256_si128( attacks ) , _mm256_extracti128_si256( attacks , 1 ) );
+	return uint64_t( _mm_cvtsi128_si64( _mm_or_si128( half , _mm_unpackhi_epi64( half , half ) ) ) );
+}
+#endif
@@ -15,13 +15,18 @@ public:
 	lchessThreatMap();
 	virtual ~lchessThreatMap();
 
+	// the squares each color attacks in the position, computed with attacksOf
 	static lchessThreatMap fromBoard( const lchessBoard& board );
 
-	// a greedy check whether white is in check, it will return as soon as a check is found
+	// whether white is in check, only looks outward from the white king for attackers
 	static bool isWhiteInCheck( const lchessBoard& board );
-	// a greedy check whether black is in check, it will return as soon as a check is found
+	// whether black is in check, only looks outward from the black king for attackers
 	static bool isBlackInCheck( const lchessBoard& board );
 
+	// all squares the pieces of the given color attack, computed for the whole color at once with the given occupancy
+	// for the sliders, e.g. without the enemy king to find the squares the king cannot move to
+	static uint64_t attacksOf( const lchessBoard& board , const BYTE color , const uint64_t occupancy );
+
 	bool isWhiteThreat( const int index ) const;
 	bool isBlackThreat( const int index ) const;
 
@@ -31,7 +36,14 @@ private:
 	int64_t white;
 	int64_t black;
 
-	void init( const lchessBoard& board );
+	// the attacks of all rook movers (straight) and all bishop movers (diagonal) in all eight directions at once, the
+	// implementation is picked once at startup depending on what the cpu supports
+	typedef uint64_t (*SlidingAttacksFunction)( const uint64_t straight , const uint64_t diagonal , const uint64_t empty );
+	static const SlidingAttacksFunction slidingAttacks;
 
-	static inline int toIndex( const int x , const int y ) { return y*8+x; }
+	static SlidingAttacksFunction selectSlidingAttacks();
+	static uint64_t slidingAttacksScalar( const uint64_t straight , const uint64_t diagonal , const uint64_t empty );
+#ifdef LCHESS_AVX2
+	static uint64_t slidingAttacksAvx2( const uint64_t straight , const uint64_t diagonal , const uint64_t empty );
+#endif
 };
\ No newline at end of file
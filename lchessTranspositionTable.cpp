@@ -0,0 +1,215 @@
+/*
+use at own risk
+*/
+#include "lchessTranspositionTable.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+
+lchessTranspositionTable::lchessTranspositionTable()
+{
+	this->buckets = nullptr;
+	this->mask = 0;
+	this->allocated = 0;
+	this->age = 0;
+}
+
+
+
+lchessTranspositionTable::~lchessTranspositionTable()
+{
+	this->release();
+}
+
+
+
+void lchessTranspositionTable::resize( const size_t megabytes , const bool hugePages , const int threads )
+{
+	this->release();
+
+	size_t count = 1;
+	while ( count*2*sizeof( Bucket ) <= megabytes*1024*1024 ) count *= 2;
+
+	// huge pages need the memory aligned to their size, the kernel falls back to normal pages if it has none
+	const size_t alignment = hugePages ? 2*1024*1024 : 64;
+	this->allocated = ( ( count*sizeof( Bucket )+alignment-1 )/alignment )*alignment;
+	void* memory = nullptr;
+#if defined(_MSC_VER)
+	memory = _aligned_malloc( this->allocated , alignment );
+#else
+	if ( posix_memalign( &memory , alignment , this->allocated ) != 0 ) memory = nullptr;
+#endif
+	if ( !memory )
+	{
+		std::cout << "lchessTranspositionTable > resize > could not allocate " << megabytes << "MB" << std::endl;
+		this->allocated = 0;
+		return;
+	}
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if ( hugePages ) madvise( memory , this->allocated , MADV_HUGEPAGE );
+#endif
+
+	// the entries are atomics, so the buckets are constructed in place before they are used, which also empties them
+	this->buckets = static_cast<Bucket*>( memory );
+	this->mask = count-1;
+	this->forEachSlice( threads , []( Bucket* begin , Bucket* end )
+	{
+		for ( Bucket* bucket = begin ; bucket != end ; ++bucket ) new ( bucket ) Bucket();
+	} );
+	this->age = 0;
+}
+
+
+
+void lchessTranspositionTable::clear( const int threads )
+{
+	if ( !this->buckets ) return;
+
+	// all zero bits are an empty entry, the words are atomics so they are cleared with stores and not with memset
+	this->forEachSlice( threads , []( Bucket* begin , Bucket* end )
+	{
+		for ( Bucket* bucket = begin ; bucket != end ; ++bucket )
+		{
+			for ( Entry& e : bucket->entries )
+			{
+				e.key.store( 0 , std::memory_order_relaxed );
+				e.data.store( 0 , std::memory_order_relaxed );
+			}
+		}
+	} );
+	this->age = 0;
+}
+
+
+
+bool lchessTranspositionTable::probe( const uint64_t hash , lchessTTEntry& entry ) const
+{
+	if ( !this->buckets ) return false;
+
+	const Bucket& bucket = this->buckets[hash & this->mask];
+	for ( const Entry& e : bucket.entries )
+	{
+		const uint64_t data = e.data.load( std::memory_order_relaxed );
+		if ( data == 0 || ( e.key.load( std::memory_order_relaxed ) ^ data ) != hash ) continue;
+
+		entry.move = lchessCompactMove::fromRaw( uint16_t( data ) );
+		entry.score = int16_t( data >> 16 );
+		entry.depth = dataDepth( data );
+		entry.bound = dataBound( data );
+		return true;
+	}
+	return false;
+}
+
+
+
+void lchessTranspositionTable::store( const uint64_t hash , const lchessCompactMove move , const int score , const int depth , const lchessBound bound )
+{
+	if ( !this->buckets ) return;
+
+	Bucket& bucket = this->buckets[hash & this->mask];
+
+	// the entry of the same position if there is one, otherwise the one with the least value, entries of older
+	// searches lose 8 plies of depth for every search they are old
+	Entry* replace = &bucket.entries[0];
+	int lowestValue = 1 << 30;
+	uint64_t oldData = 0;
+	for ( Entry& e : bucket.entries )
+	{
+		const uint64_t data = e.data.load( std::memory_order_relaxed );
+		if ( data != 0 && ( e.key.load( std::memory_order_relaxed ) ^ data ) == hash )
+		{
+			replace = &e;
+			oldData = data;
+			break;
+		}
+		const int relativeAge = int( ( this->age-dataAge( data ) ) & AGE_MASK );
+		const int value = ( data == 0 ) ? -( 1 << 20 ) : dataDepth( data )-8*relativeAge;
+		if ( value < lowestValue )
+		{
+			lowestValue = value;
+			replace = &e;
+		}
+	}
+
+	if ( oldData != 0 )
+	{
+		// a shallower result of the same search does not overwrite a deeper exact one
+		if ( bound != BOUND_EXACT && depth < dataDepth( oldData )-2 && dataAge( oldData ) == this->age ) return;
+	}
+
+	// keep the old best move if the new result has none
+	lchessCompactMove bestMove = move;
+	if ( bestMove.isNull() && oldData != 0 ) bestMove = lchessCompactMove::fromRaw( uint16_t( oldData ) );
+
+	const uint64_t data = pack( bestMove , score , depth , bound , this->age );
+	replace->key.store( hash ^ data , std::memory_order_relaxed );
+	replace->data.store( data , std::memory_order_relaxed );
+}
+
+
+
+int lchessTranspositionTable::hashfull() const
+{
+	if ( !this->buckets ) return 0;
+
+	const uint64_t count = std::min<uint64_t>( 1000 , this->mask+1 );
+	uint64_t used = 0;
+	for ( uint64_t i = 0 ; i < count ; ++i )
+	{
+		for ( const Entry& e : this->buckets[i].entries )
+		{
+			const uint64_t data = e.data.load( std::memory_order_relaxed );
+			if ( data != 0 && dataAge( data ) == this->age ) ++used;
+		}
+	}
+	return int( used*1000/( count*BUCKET_ENTRIES ) );
+}
+
+
+
+/*
+private functions
+*/
+
+
+
+void lchessTranspositionTable::release()
+{
+	if ( !this->buckets ) return;
+#if defined(_MSC_VER)
+	_aligned_free( this->buckets );
+#else
+	free( this->buckets );
+#endif
+	this->buckets = nullptr;
+	this->mask = 0;
+	this->allocated = 0;
+}
+
+
+
+void lchessTranspositionTable::forEachSlice( const int threads , const std::function<void( Bucket* , Bucket* )>& function )
+{
+	const size_t count = this->mask+1;
+	const size_t slice = ( count+std::max( 1 , threads )-1 )/std::max( 1 , threads );
+
+	std::vector<std::thread> pool;
+	for ( int i = 1 ; i < threads ; ++i )
+	{
+		const size_t begin = i*slice;
+		if ( begin >= count ) break;
+		pool.emplace_back( [=]() { function( this->buckets+begin , this->buckets+std::min( begin+slice , count ) ); } );
+	}
+	function( this->buckets , this->buckets+std::min( slice , count ) );
+	for ( std::thread& thread : pool ) thread.join();
+}
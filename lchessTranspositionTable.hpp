@@ -0,0 +1,116 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+#include "lchessBoard.hpp"
+
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+
+
+// what the stored score says about the real score of the position
+enum lchessBound
+{
+	BOUND_NONE,
+	BOUND_UPPER,	// the real score is at most the stored one, no move reached alpha
+	BOUND_LOWER,	// the real score is at least the stored one, a move reached beta
+	BOUND_EXACT
+};
+
+/*
+the result of a probe, unpacked from the 64 bits an entry stores
+*/
+struct lchessTTEntry
+{
+	lchessCompactMove move;
+	int16_t score;
+	int depth;
+	lchessBound bound;
+};
+
+
+
+/*
+a fixed size hash table of search results shared by all threads without locks, every entry is two 64 bit words and the
+key word is stored xor-ed with the data word, so an entry torn by two threads writing at once does not match any
+position, the entries are grouped into buckets of one cache line so a probe touches a single line
+*/
+class lchessTranspositionTable
+{
+public:
+	static constexpr int BUCKET_ENTRIES = 4;
+
+	lchessTranspositionTable();
+	virtual ~lchessTranspositionTable();
+
+	// allocates the largest power of two number of buckets that fits into the given size and clears them, with huge
+	// pages the memory is aligned to 2MB and the kernel is asked to back it with transparent huge pages
+	void resize( const size_t megabytes , const bool hugePages = true , const int threads = 1 );
+	// sets every entry to empty, the table is split into one slice per thread
+	void clear( const int threads = 1 );
+
+	// starts a new search, entries of older searches are replaced first
+	inline void newSearch() { this->age = ( this->age+1 ) & AGE_MASK; }
+
+	// returns true and fills entry if the position is in the table
+	bool probe( const uint64_t hash , lchessTTEntry& entry ) const;
+	void store( const uint64_t hash , const lchessCompactMove move , const int score , const int depth , const lchessBound bound );
+
+	// loads the bucket of the position into the cache ahead of the probe
+	inline void prefetch( const uint64_t hash ) const
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		if ( this->buckets ) __builtin_prefetch( &this->buckets[hash & this->mask] );
+#endif
+	}
+
+	// how full the table is in permille, estimated from the first thousand buckets
+	int hashfull() const;
+
+	inline size_t getSize() const { return this->buckets ? ( this->mask+1 )*sizeof( Bucket ) : 0; }
+
+private:
+	static constexpr uint64_t AGE_MASK = 0x3F;
+
+	// the data word: move 16 bits, score 16 bits, depth 8 bits, bound 2 bits, age 6 bits
+	struct Entry
+	{
+		std::atomic<uint64_t> key;
+		std::atomic<uint64_t> data;
+
+		Entry() : key( 0 ) , data( 0 ) {}
+	};
+
+	struct alignas( 64 ) Bucket
+	{
+		Entry entries[BUCKET_ENTRIES];
+	};
+
+	static_assert( sizeof( Bucket ) == 64 , "a bucket has to fill exactly one cache line" );
+	// the memory is freed without running destructors
+	static_assert( std::is_trivially_destructible<Bucket>::value , "a bucket must not need a destructor" );
+
+	Bucket* buckets;
+	uint64_t mask;
+	size_t allocated;
+	uint64_t age;
+
+	static inline uint64_t pack( const lchessCompactMove move , const int score , const int depth , const lchessBound bound , const uint64_t age )
+	{
+		return uint64_t( move.raw() ) | ( uint64_t( uint16_t( score ) ) << 16 ) | ( uint64_t( uint8_t( depth ) ) << 32 ) | ( uint64_t( bound ) << 40 ) | ( age << 42 );
+	}
+
+	static inline int dataDepth( const uint64_t data ) { return int( int8_t( data >> 32 ) ); }
+	static inline lchessBound dataBound( const uint64_t data ) { return lchessBound( ( data >> 40 ) & 0x3 ); }
+	static inline uint64_t dataAge( const uint64_t data ) { return ( data >> 42 ) & AGE_MASK; }
+
+	void release();
+	// splits the buckets into one slice per thread and runs the function on every slice, so the pages are first
+	// touched by the threads that will use them
+	void forEachSlice( const int threads , const std::function<void( Bucket* , Bucket* )>& function );
+};
@@ -0,0 +1,46 @@
+/*
+use at own risk
+*/
+#include "lchessZobrist.hpp"
+
+
+
+constexpr lchessZobrist::Keys lchessZobrist::buildKeys()
+{
+	Keys k = {};
+	uint64_t seed = 0x9E3779B97F4A7C15ULL;
+	auto random = [&seed]() -> uint64_t
+	{
+		// splitmix64
+		uint64_t z = ( seed += 0x9E3779B97F4A7C15ULL );
+		z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+		z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+		return z ^ ( z >> 31 );
+	};
+
+	for ( int c = 0 ; c < 2 ; ++c )
+	{
+		for ( int t = 0 ; t < 6 ; ++t )
+		{
+			for ( int i = 0 ; i < 64 ; ++i ) k.pieces[c][t][i] = random();
+		}
+	}
+
+	// every right has its own key and a set of rights is the xor of them, so rights can be removed one at a time
+	uint64_t rights[4] = { random() , random() , random() , random() };
+	for ( int r = 0 ; r < 16 ; ++r )
+	{
+		for ( int b = 0 ; b < 4 ; ++b )
+		{
+			if ( r & ( 1 << b ) ) k.castling[r] ^= rights[b];
+		}
+	}
+
+	for ( int f = 0 ; f < 8 ; ++f ) k.enPassant[f] = random();
+	k.side = random();
+	return k;
+}
+
+
+
+constexpr lchessZobrist::Keys lchessZobrist::keys = lchessZobrist::buildKeys();
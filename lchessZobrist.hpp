@@ -0,0 +1,53 @@
+/*
+use at own risk
+*/
+#pragma once
+
+#include "lchess_includes.hpp"
+
+
+
+/*
+random keys for hashing positions, the hash of a position is the xor of the keys of everything in it, so a move only
+has to xor in the keys of what it changed
+*/
+class lchessZobrist
+{
+public:
+	static inline uint64_t piece( const BYTE piece , const int index )
+	{
+		return keys.pieces[( piece >> 5 ) & 1][piece & PIECE_TYPE_MASK][index];
+	}
+
+	// the castle rights as four bits, white king side, white queen side, black king side and black queen side
+	static inline uint64_t castling( const int rights )
+	{
+		return keys.castling[rights];
+	}
+
+	// the file of a pawn that can be captured en passant
+	static inline uint64_t enPassant( const int file )
+	{
+		return keys.enPassant[file];
+	}
+
+	// xor-ed in when black is to move
+	static inline uint64_t side()
+	{
+		return keys.side;
+	}
+
+private:
+	// all keys are computed by the compiler from a fixed seed, so hashes are the same on every run
+	struct Keys
+	{
+		uint64_t pieces[2][6][64];
+		uint64_t castling[16];
+		uint64_t enPassant[8];
+		uint64_t side;
+	};
+
+	static const Keys keys;
+
+	static constexpr Keys buildKeys();
+};
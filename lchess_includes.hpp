@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdint>
 
 // Define macros or constants if needed
 #define MAX_MOVES 100
@@ -15,6 +16,49 @@
 #define BYTE uint8_t
 #endif
 
+// Define pieces and colors
+
+#define EMPTY 0x00
+
+#define WHITE 0x10
+#define BLACK 0x20
+
+// a piece is its color or-ed with its type
+#define PAWN 0x00
+#define ROOK 0x01
+#define KNIGHT 0x02
+#define BISHOP 0x03
+#define QUEEN 0x04
+#define KING 0x05
+
+#define PIECE_TYPE_MASK 0x0F
+#define PIECE_COLOR_MASK 0x30
+
+// a square index that is not on the board
+#define NO_SQUARE 64
+
+// the avx2 code is compiled with a function target attribute and only used if the cpu supports it at runtime
+#if ( defined(__GNUC__) || defined(__clang__) ) && defined(__x86_64__)
+#define LCHESS_AVX2
+#endif
+
+// building with -DLCHESS_DEBUG_CHECKS recomputes the hash and the evaluation from scratch after every move and
+// unmake and asserts they match the incremental ones, it is slow and off in every other build, debug builds included
+
+#define WHITE_PAWN 0x10
+#define WHITE_ROOK 0x11
+#define WHITE_KNIGHT 0x12
+#define WHITE_BISHOP 0x13
+#define WHITE_QUEEN 0x14
+#define WHITE_KING 0x15
+
+#define BLACK_PAWN 0x20
+#define BLACK_ROOK 0x21
+#define BLACK_KNIGHT 0x22
+#define BLACK_BISHOP 0x23
+#define BLACK_QUEEN 0x24
+#define BLACK_KING 0x25
+
 // Define lchessGameState which could be lchessGameState::BLACKWIN, lchessGameState::WHITEWIN, lchessGameState::DRAW, lchessGameState::ONGOING
 enum lchessGameState
 {
@@ -0,0 +1,107 @@
+/*
+use at own risk
+*/
+
+// perft driver, counts the leaf nodes of the move tree to check and time the move generation
+//
+// perft suite [max depth]          runs the reference positions, default max depth is 5
+// perft <depth> [fen]              counts the nodes of the position, default is the start position
+// perft divide <depth> [fen]       the same with the count below every root move
+//
+// -t <threads> anywhere on the command line spreads the counting over several threads
+// -c <megabytes> looks up subtrees that were counted before in a cache of that size
+
+#include "lchessPerft.hpp"
+
+#include <cstdlib>
+
+
+
+static void printUsage()
+{
+	std::cout << "usage: perft suite [max depth]" << std::endl;
+	std::cout << "       perft <depth> [fen]" << std::endl;
+	std::cout << "       perft divide <depth> [fen]" << std::endl;
+	std::cout << "options: -t <threads> -c <cache megabytes>" << std::endl;
+}
+
+
+
+// the fen is given as the remaining arguments so it does not have to be quoted
+static bool setupBoard( lchessBoard& board , const int argc , char** argv , const int first )
+{
+	board.init();
+	if ( first >= argc ) return true;
+
+	std::string fen = argv[first];
+	for ( int i = first+1 ; i < argc ; ++i ) fen += std::string( " " )+argv[i];
+	return board.loadFen( fen );
+}
+
+
+
+int main( int argc , char** argv )
+{
+	lchessBoard::allocateMemory();
+
+	// take the options out of the arguments
+	int threads = 1;
+	int cacheSize = 0;
+	int count = 1;
+	for ( int i = 1 ; i < argc ; ++i )
+	{
+		if ( std::string( argv[i] ) == "-t" && i+1 < argc ) threads = std::max( 1 , atoi( argv[++i] ) );
+		else if ( std::string( argv[i] ) == "-c" && i+1 < argc ) cacheSize = std::max( 0 , atoi( argv[++i] ) );
+		else argv[count++] = argv[i];
+	}
+	argc = count;
+
+	std::unique_ptr<lchessPerftCache> cache;
+	if ( cacheSize > 0 ) cache.reset( new lchessPerftCache( cacheSize ) );
+
+	if ( argc < 2 )
+	{
+		printUsage();
+		return 1;
+	}
+
+	const std::string command = argv[1];
+
+	if ( command == "suite" )
+	{
+		const int maxDepth = ( argc > 2 ) ? atoi( argv[2] ) : 5;
+		return lchessPerft::runSuite( maxDepth , threads , cache.get() ) ? 0 : 1;
+	}
+
+	const bool divide = ( command == "divide" );
+	const int depthArgument = divide ? 2 : 1;
+	if ( depthArgument >= argc || atoi( argv[depthArgument] ) < 1 )
+	{
+		printUsage();
+		return 1;
+	}
+	const int depth = atoi( argv[depthArgument] );
+
+	lchessBoard board;
+	if ( !setupBoard( board , argc , argv , depthArgument+1 ) ) return 1;
+
+	Timer timer;
+	timer.start();
+	std::vector<uint64_t> threadNodes;
+	uint64_t nodes = 0;
+	if ( divide ) nodes = lchessPerft::divide( board , depth , cache.get() );
+	else if ( threads > 1 ) nodes = lchessPerft::parallelPerft( board , depth , threads , &threadNodes , cache.get() );
+	else nodes = lchessPerft::perft( board , depth , cache.get() );
+	const double time = timer.getTime();
+
+	for ( size_t i = 0 ; i < threadNodes.size() ; ++i )
+	{
+		std::cout << "thread " << i << " nodes " << threadNodes[i] << std::endl;
+	}
+
+	std::cout << "depth " << depth << " nodes " << nodes << " time " << time << "s nps " << uint64_t( nodes/std::max( time , 1e-9 ) ) << std::endl;
+#ifdef LCHESS_INSTRUMENTATION
+	lchessInstrumentation::dump( std::cout );
+#endif
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*
+use at own risk
+*/
+
+// search driver, prints the best move of a position and the line the search expects
+//
+// search [fen]                     searches the position, default is the start position
+//
+// -d <depth> stops after the iteration of that depth
+// -n <nodes> stops after about that many nodes
+// -m <milliseconds> stops after that much time
+// -h <megabytes> is the size of the transposition table, default is 16
+// -t <threads> searches with several threads sharing the transposition table
+// -e <file> evaluates with the network weights in the file instead of the piece-square tables
+// without any limit the search runs to depth 8
+
+#include "lchessSearch.hpp"
+
+#include <cstdlib>
+
+
+
+int main( int argc , char** argv )
+{
+	lchessBoard::allocateMemory();
+
+	// take the options out of the arguments
+	lchessSearchLimits limits;
+	int hashSize = 16;
+	int threads = 1;
+	std::string networkFile;
+	int count = 1;
+	for ( int i = 1 ; i < argc ; ++i )
+	{
+		if ( std::string( argv[i] ) == "-d" && i+1 < argc ) limits.depth = std::max( 1 , atoi( argv[++i] ) );
+		else if ( std::string( argv[i] ) == "-n" && i+1 < argc ) limits.nodes = std::max( 0 , atoi( argv[++i] ) );
+		else if ( std::string( argv[i] ) == "-m" && i+1 < argc ) limits.time = std::max( 0 , atoi( argv[++i] ) );
+		else if ( std::string( argv[i] ) == "-h" && i+1 < argc ) hashSize = std::max( 1 , atoi( argv[++i] ) );
+		else if ( std::string( argv[i] ) == "-t" && i+1 < argc ) threads = std::max( 1 , atoi( argv[++i] ) );
+		else if ( std::string( argv[i] ) == "-e" && i+1 < argc ) networkFile = argv[++i];
+		else argv[count++] = argv[i];
+	}
+	argc = count;
+	if ( limits.depth == 0 && limits.nodes == 0 && limits.time == 0 ) limits.depth = 8;
+
+	// the fen is given as the remaining arguments so it does not have to be quoted
+	lchessNetwork network;
+	if ( !networkFile.empty() && !network.load( networkFile ) ) return 1;
+
+	lchessBoard board;
+	board.setNetwork( &network );
+	board.init();
+	if ( argc > 1 )
+	{
+		std::string fen = argv[1];
+		for ( int i = 2 ; i < argc ; ++i ) fen += std::string( " " )+argv[i];
+		if ( !board.loadFen( fen ) ) return 1;
+	}
+
+	lchessSearch search( hashSize , threads );
+	const lchessSearchResult result = search.search( board , limits , []( const lchessSearchResult& info )
+	{
+		std::cout << "depth " << info.depth << " score " << info.score << " nodes " << info.nodes << " time " << info.time << "s hashfull " << info.hashfull << " pv " << info.pvString() << std::endl;
+	} );
+
+	if ( threads > 1 )
+	{
+		for ( size_t i = 0 ; i < result.threadNodes.size() ; ++i )
+		{
+			std::cout << "thread " << i << " nodes " << result.threadNodes[i] << std::endl;
+		}
+	}
+
+	std::cout << "bestmove " << ( result.bestMove.isNull() ? std::string( "none" ) : result.bestMove.toString() ) << " nodes " << result.nodes << " time " << result.time << "s nps " << uint64_t( result.nodes/std::max( result.time , 1e-9 ) ) << std::endl;
+	return 0;
+}